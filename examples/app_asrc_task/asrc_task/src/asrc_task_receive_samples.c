@@ -19,7 +19,7 @@ unsigned receive_asrc_input_samples(chanend_t c_producer, asrc_in_out_t *asrc_io
     }
 
     // Keep track of frame block to ASRC task
-    if(++asrc_in_counter == SRC_N_IN_SAMPLES){
+    if(++asrc_in_counter >= asrc_io->input_block_size){
         asrc_in_counter = 0;
     }
 
@@ -24,7 +24,8 @@
  * Function that interpolates a timestamp for a sample generated by the ASRC.
  * Given a measured timestamp for the sample going into the ASRC, the asrc control
  * structure, and the expected output frequency, this function returns a timestamp
- * for when the last sample was produced by the ASRC.
+ * for when the last sample was produced by the ASRC. The result is taken
+ * modulo 2^32, so it wraps with the reference clock.
  *
  * @param  timestamp       Value of the reference clock taken when the last sample
  *                         fed into the ASRC was sampled.
@@ -36,6 +37,28 @@
  */
 int asrc_timestamp_interpolation(int timestamp, asrc_ctrl_t * UNSAFE asrc_ctrl, int ideal_freq);
 
+/**
+ * Function that interpolates a timestamp for a sample generated by the ASRC
+ * to a fraction of a tick, using all of the ASRC fractional time. The
+ * result is meant for asynchronous_fifo_producer_put_fract().
+ *
+ * @param  timestamp       Value of the reference clock taken when the last sample
+ *                         fed into the ASRC was sampled.
+ *
+ * @param  asrc_ctrl       ASRC control block
+ *
+ * @param  ideal_freq      Expected base frequency to which the ASRC is operating;
+ *                         eg, 48000 or 44100
+ *
+ * @param  fract           Set to the fraction of a tick to add to the
+ *                         returned timestamp, as an unsigned 0.32 fixed
+ *                         point number.
+ *
+ * @returns The whole ticks of the interpolated timestamp
+ */
+int asrc_timestamp_interpolation_fract(int timestamp, asrc_ctrl_t * UNSAFE asrc_ctrl, int ideal_freq,
+                                       uint32_t * UNSAFE fract);
+
 /**@}*/ // END: addtogroup src_fifo_interp
 
 #endif
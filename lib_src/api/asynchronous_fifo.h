@@ -9,6 +9,42 @@
 
 #define FREQUENCY_RATIO_EXPONENT     (32)
 
+/**
+ * Number of fractional bits of a tick that the phase detector of
+ * asynchronous_fifo_producer_put_fract() resolves
+ */
+#define ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS   (8)
+
+/**
+ * Largest number of samples per put (or per bulk get) for which the FIFO
+ * uses pre-scaled PID coefficients and reciprocals instead of a divide.
+ * Larger puts and gets work, but pay two divides each. The default covers
+ * the ASRC output of a 4 sample block at any supported rate pair, that is
+ * SRC_N_IN_SAMPLES * SRC_N_OUT_IN_RATIO_MAX = 20; asrc_task checks that its
+ * configuration fits. At most 128. It sizes asynchronous_fifo_t, so set it
+ * for the whole application (eg, on the compiler command line), not in a
+ * single file.
+ */
+#ifndef ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH
+#define ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH   (24)
+#endif
+
+/**
+ * In adaptive depth mode, the phase target ramps down by one tick per
+ * this many ticks of samples, about 30 ppm.
+ */
+#ifndef ASYNCHRONOUS_FIFO_DEPTH_SLEW_TICKS
+#define ASYNCHRONOUS_FIFO_DEPTH_SLEW_TICKS   (32768)
+#endif
+
+/**
+ * Scale factor for asynchronous_fifo_init_timestamp_scale() that converts
+ * timestamps counted at hz to ticks of the 100 MHz reference clock.
+ * For example, ASYNCHRONOUS_FIFO_TIMESTAMP_SCALE(1000000000) for
+ * nanoseconds.
+ */
+#define ASYNCHRONOUS_FIFO_TIMESTAMP_SCALE(hz) ((uint64_t)((100000000ull << 32) / (hz)))
+
 #ifdef __XC__
 #define UNSAFE unsafe
 #else
@@ -23,6 +59,37 @@
  */
 
 
+/**
+ * Storage format of the samples in the FIFO. The value of each format is the
+ * number of bytes stored per sample. The packed formats keep the most
+ * significant 24 or 16 bits of each sample.
+ */
+typedef enum asynchronous_fifo_format_t_ {
+    ASYNCH_FIFO_FORMAT_INT32 = 4,             /**< Full 32-bit samples */
+    ASYNCH_FIFO_FORMAT_PACKED24 = 3,          /**< 24-bit samples, packed four to three words */
+    ASYNCH_FIFO_FORMAT_INT16 = 2              /**< 16-bit samples, packed two to a word */
+} asynchronous_fifo_format_t;
+
+/**
+ * Run time statistics of one consumer of an asynchronous FIFO, see
+ * asynchronous_fifo_enable_stats(). All fill levels are in frames, counted
+ * by the producer just before each put, and phase errors in ticks.
+ */
+typedef struct asynchronous_fifo_stats_t_ {
+    uint32_t  sequence;                       /**< Odd while the producer is updating */
+    int32_t   min_fill;                       /**< Lowest fill level */
+    int32_t   max_fill;                       /**< Highest fill level */
+    int32_t   mean_fill;                      /**< Mean fill level in 1/256 frames, set by asynchronous_fifo_get_stats() */
+    uint64_t  fill_sum;                       /**< Sum of the fill levels */
+    uint64_t  fill_count;                     /**< Number of fill levels summed */
+    uint32_t  underflows;                     /**< Number of underflows, counted by the consumer */
+    uint32_t  overflows;                      /**< Number of overflows */
+    uint32_t  resets;                         /**< Number of resets completed by the producer */
+    int32_t   ratio;                          /**< Current frequency ratio, as returned by the producer */
+    int32_t   max_phase_error;                /**< Largest absolute phase error since lock */
+    uint64_t  locked_frames;                  /**< Frames produced since lock, 0 if not locked */
+} asynchronous_fifo_stats_t;
+
 /**
  * Data structure that holds the status of an asynchronous FIFO
  */
@@ -31,19 +98,50 @@ typedef struct asynchronous_fifo_t_ {
     int32_t   channel_count;                  /* Number of audio channels */
     int32_t   copy_mask;                      /* Number of audio channels */
     int32_t   max_fifo_depth;                 /* Length of buffer[] in channel_counts */
+    uint32_t  index_mask;                     /* max_fifo_depth-1 if a power of two, otherwise all ones */
+    int32_t   format;                         /* Storage format, an asynchronous_fifo_format_t */
+    int32_t   frame_words;                    /* Words occupied by one frame in buffer[] */
+    int32_t   timestamp_shift;                /* log2 of the number of frames per timestamp */
+    int32_t   ticks_between_samples;          /* Ideal ticks between samples */
+    int32_t   consumer_count;                 /* Number of consumers sharing the samples */
+    int32_t   * UNSAFE samples;               /* Frame storage, buffer[] of the first consumer */
+    struct asynchronous_fifo_t_ * UNSAFE next_consumer; /* Next consumer of a broadcast FIFO, or NULL */
     int32_t   ideal_phase_error_ticks;        /* Ideal ticks between samples */
     int32_t   Ki;                             /* Ki PID coefficient */
     int32_t   Kp;                             /* Kp PID coefficient */
+    int32_t   Kp_n[ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH]; /* Kp/n for n = 1.. */
+    int32_t   gain_boost_max;                 /* log2 of the PID bandwidth boost after a reset */
+    int32_t   settle_ticks;                   /* Phase error below which the loop counts as settled */
+    int32_t   settle_puts;                    /* Settled puts before the boost is stepped down */
+    int32_t   adapt_margin;                   /* Frames of headroom kept in adaptive depth mode, 0 if off */
+    int32_t   adapt_window;                   /* Puts observed before the target is lowered */
+    int32_t   slew_frames;                    /* Frames per tick of ramp when the target is lowered */
+    asynchronous_fifo_stats_t * UNSAFE stats; /* Run time statistics, or NULL */
+    uint64_t  timestamp_scale;                /* Ticks per timestamp unit in 32.32, for asynchronous_fifo_scale_timestamp() */
+    int32_t   ratio_seed;                     /* Ratio the PID starts from after a reset, 0 unless seeded */
 
     // Updated on the producer side only
     int       skip_ctr;                       /* Set to indicate initialisation runs */
-    int32_t   write_ptr;                      /* Write index in the buffer */
+    uint32_t  write_ptr;                      /* Write index in the buffer */
     int64_t   last_phase_error;               /* previous error, used for proportional */
+    int64_t   last_proportional;              /* previous proportional term, Kp/n times the error */
     int64_t   frequency_ratio;                /* Current ratio of frequencies in 64.64 */
     int32_t   stop_producing;                 /* In case of overflow, stops producer until consumer restarts and requests a reset */
+    uint32_t  shared_write_ptr;               /* Write index of a broadcast FIFO, in the first consumer */
+    int32_t   ratio;                          /* Last frequency ratio, as returned by the producer */
+    int32_t   gain_boost;                     /* Current log2 PID bandwidth boost */
+    uint32_t  last_put_timestamp;             /* Timestamp of the previous sub-tick put */
+    uint32_t  last_put_fract;                 /* and its fraction of a tick */
+    int32_t   target_depth;                   /* Target fill level in frames, adaptive depth mode */
+    int32_t   adapt_ctr;                      /* Puts in the current observation window */
+    int32_t   adapt_min_len;                  /* Lowest fill level in the current window */
+    int32_t   slew_ctr;                       /* Frames towards the next tick of ramp */
+    int32_t   settle_ctr;                     /* Puts in the current settling window */
+    int64_t   settle_sum;                     /* Sum of the phase errors in the window, in ticks */
 
     // Updated on the consumer side only
     uint32_t  read_ptr;                       /* Read index in the buffer */
+    uint32_t  last_timestamp;                 /* Timestamp of the previous get, used to spread bulk timestamps */
 
     // Set by producer, reset by consumer
     uint32_t  reset;                          /* Set to 1 if consumer wants a reset */
@@ -71,12 +169,120 @@ typedef struct asynchronous_fifo_t_ {
  *
  * @param   channel_count       Number of audio channels
  *
- * @param   max_fifo_depth      Length of the FIFO, delay when stable will be max_fifo_depth/2
+ * @param   max_fifo_depth      Length of the FIFO, delay when stable will be max_fifo_depth/2.
+ *                              A power of two is preferred: the read and write
+ *                              pointers then become free-running counters that
+ *                              are masked, so no divide or wrap test is needed
+ *                              on either the producer or the consumer side.
  */
 void asynchronous_fifo_init(asynchronous_fifo_t * UNSAFE state,
                             int channel_count,
                             int max_fifo_depth);
 
+/**
+ * Function that initialises an asynchronous FIFO that stores its samples in a
+ * packed format and/or records one timestamp per group of frames, reducing
+ * the memory needed for a FIFO with many channels or a large depth.
+ * The ``state`` argument should be an int64_t array of
+ * ``ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT`` elements that is cast to
+ * ``asynchronous_fifo_t*``. Samples are put and got as int32_t in all
+ * formats; the bits that are not stored read back as zero.
+ *
+ * asynchronous_fifo_init() is the same as this function with
+ * ``ASYNCH_FIFO_FORMAT_INT32`` and a ``timestamp_decimation`` of 1.
+ *
+ * @param   state               Asynchronous FIFO to be initialised
+ *
+ * @param   channel_count       Number of audio channels
+ *
+ * @param   max_fifo_depth      Length of the FIFO, delay when stable will be max_fifo_depth/2
+ *
+ * @param   format              Storage format of the samples
+ *
+ * @param   timestamp_decimation Number of frames per recorded timestamp, a
+ *                              power of 2 of at most max_fifo_depth/4. The
+ *                              producer extrapolates the frames in between
+ *                              using the ticks between samples that the PID
+ *                              was initialised with. In adaptive depth mode
+ *                              the target fill level does not go below it.
+ *
+ * @returns 0 on success, or -1 if timestamp_decimation is not valid, in
+ *          which case the FIFO is not initialised.
+ */
+int asynchronous_fifo_init_format(asynchronous_fifo_t * UNSAFE state,
+                                  int channel_count,
+                                  int max_fifo_depth,
+                                  asynchronous_fifo_format_t format,
+                                  int timestamp_decimation);
+
+/**
+ * Function that initialises a broadcast FIFO: one producer and
+ * ``consumer_count`` consumers. The frames are stored once and every
+ * consumer has its own read pointer, timestamps and PID, so the work of
+ * producing the frames (eg, an ASRC) is shared between all sinks. The
+ * ``state`` argument should be an int64_t array of
+ * ``ASYNCHRONOUS_FIFO_BROADCAST_INT64_ELEMENTS`` elements that is cast to
+ * ``asynchronous_fifo_t*``.
+ *
+ * The producer calls asynchronous_fifo_producer_put() on ``state``, which
+ * returns the frequency ratio of the first consumer, and produces the
+ * frames at that rate for all of them. So all consumers must be clocked
+ * from consumer 0's clock; they may differ in phase and latency, but not
+ * in frequency. Only consumer 0 runs a PID. The other consumers only
+ * measure: their phase error is in the ``last_phase_error`` member of
+ * their handle and their fill levels are in their statistics, but their
+ * ``ratio`` is not updated and adaptive depth mode does not apply to them.
+ *
+ * Fanning one ASRC out to sinks on different clock domains, eg, I2S and
+ * USB clocked separately, is not supported: one ASRC output can only track
+ * one clock, so each such sink needs its own ASRC. A consumer on a
+ * different clock drifts until it overflows or underflows, and resets.
+ *
+ * Each consumer uses its own handle, from
+ * asynchronous_fifo_broadcast_consumer(), for
+ * asynchronous_fifo_consumer_get(), asynchronous_fifo_reset_consumer() and
+ * for one of the PID initialisation functions. A consumer that overflows,
+ * for example because it stopped pulling, is stopped before any of its
+ * unread frames are overwritten and resets on its next get; a consumer
+ * that underflows resets too. Neither disturbs the others.
+ *
+ * @param   state               Asynchronous FIFO to be initialised
+ *
+ * @param   consumer_count      Number of consumers
+ *
+ * @param   channel_count       Number of audio channels
+ *
+ * @param   max_fifo_depth      Length of the FIFO, delay when stable will be max_fifo_depth/2
+ *
+ * @param   format              Storage format of the samples
+ *
+ * @param   timestamp_decimation Number of frames per recorded timestamp, as
+ *                              for asynchronous_fifo_init_format().
+ *
+ * @returns 0 on success, or -1 if timestamp_decimation is not valid, in
+ *          which case the FIFO is not initialised.
+ */
+int asynchronous_fifo_broadcast_init(asynchronous_fifo_t * UNSAFE state,
+                                     int consumer_count,
+                                     int channel_count,
+                                     int max_fifo_depth,
+                                     asynchronous_fifo_format_t format,
+                                     int timestamp_decimation);
+
+/**
+ * Function that returns the handle of one consumer of a broadcast FIFO.
+ * Consumer 0 is ``state`` itself.
+ *
+ * @param   state               Broadcast FIFO
+ *
+ * @param   consumer            Consumer index, less than the consumer_count
+ *                              given to asynchronous_fifo_broadcast_init()
+ *
+ * @returns The consumer's handle
+ */
+asynchronous_fifo_t * UNSAFE asynchronous_fifo_broadcast_consumer(asynchronous_fifo_t * UNSAFE state,
+                                                                  int consumer);
+
 /**
  * Function that that initialises the PID of a FIFO. Either this function
  * or asynchronous_fifo_init_PID_raw() should be called. This function
@@ -129,6 +335,158 @@ void asynchronous_fifo_init_PID_raw(asynchronous_fifo_t * UNSAFE state,
                                     int Ki,
                                     int ticks_between_samples);
 
+/**
+ * Function that schedules the PID gains for a fast lock. After every reset
+ * the loop bandwidth is boosted by 2^gain_boost (Kp is scaled by 2^gain_boost
+ * and Ki by 2^(2*gain_boost), keeping the damping), and the boost is stepped
+ * down by one each time the phase error, averaged over a window of
+ * settle_puts puts, is within settle_ticks of the target, ending at the gains set by
+ * asynchronous_fifo_init_PID_fs_codes() or asynchronous_fifo_init_PID_raw().
+ *
+ * The schedule is off (a gain_boost of 0) unless this function is called. It
+ * should be called by the producer after the PID is initialised, and restarts
+ * the schedule straight away. With a schedule the proportional term is
+ * differenced after scaling by Kp/n rather than before, so the phase error
+ * still settles to zero while the number of frames per put and the boost
+ * vary; without one the loop is unchanged.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   gain_boost          log2 of the initial bandwidth boost, 0 to 3.
+ *
+ * @param   settle_ticks        Average phase error, in ticks, below which
+ *                              the loop counts as settled at the current boost.
+ *
+ * @param   settle_puts         Number of calls to asynchronous_fifo_producer_put()
+ *                              the phase error is averaged over.
+ */
+void asynchronous_fifo_init_PID_schedule(asynchronous_fifo_t * UNSAFE state,
+                                         int gain_boost,
+                                         int settle_ticks,
+                                         int settle_puts);
+
+/**
+ * Function that sets the ratio the PID starts from, after initialisation
+ * and after every reset, instead of 0 (the nominal rates matching exactly).
+ * The ratio measured before a format change still holds afterwards if the
+ * clocks are the same, so seeding the PID with it avoids relocking from
+ * scratch. It should be called by the producer after the FIFO is
+ * initialised, and takes effect straight away.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   ratio               Starting ratio, as returned by
+ *                              asynchronous_fifo_producer_put().
+ */
+void asynchronous_fifo_init_ratio(asynchronous_fifo_t * UNSAFE state,
+                                  int32_t ratio);
+
+/**
+ * Function that enables adaptive depth mode. Instead of always aiming for
+ * half the FIFO, the producer lowers the target fill level one frame at a
+ * time while the observed fill level leaves more than margin frames of
+ * headroom above an underflow, and raises it again straight away when the
+ * headroom drops below margin. The target never exceeds half the FIFO,
+ * so the FIFO length only sets the worst case latency. After a reset the
+ * target restarts at half the FIFO. With a timestamp decimation of K the
+ * target, and the lowest fill level it is lowered from, stay above K.
+ *
+ * The target is lowered at most once per window of puts, and only once the
+ * PID has stepped down any boost set by asynchronous_fifo_init_PID_schedule().
+ * The phase target then ramps down slowly (see
+ * ASYNCHRONOUS_FIFO_DEPTH_SLEW_TICKS) so the rate barely changes.
+ *
+ * It should be called by the producer after the PID is initialised.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   margin              Frames of headroom to keep above an underflow,
+ *                              typically 2; 0 turns adaptive depth mode off.
+ *
+ * @param   window_puts         Number of calls to asynchronous_fifo_producer_put()
+ *                              over which the fill level is observed before
+ *                              the target is lowered.
+ */
+void asynchronous_fifo_init_adaptive_depth(asynchronous_fifo_t * UNSAFE state,
+                                           int margin,
+                                           int window_puts);
+
+/**
+ * Function that enables run time statistics on a FIFO, or on one consumer
+ * of a broadcast FIFO. The statistics are kept in ``stats``, which is
+ * cleared and must stay valid until the FIFO is initialised again or the
+ * statistics are disabled by passing NULL. Each put costs a few
+ * constant time updates, each underflow one increment.
+ *
+ * The FIFO counts as locked once the PID is running at its base gains,
+ * ie, after any boost set by asynchronous_fifo_init_PID_schedule(); a
+ * reset unlocks it.
+ *
+ * It should be called by the producer, before or after the PID is initialised.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   stats               Statistics block, or NULL to disable
+ */
+void asynchronous_fifo_enable_stats(asynchronous_fifo_t * UNSAFE state,
+                                    asynchronous_fifo_stats_t * UNSAFE stats);
+
+/**
+ * Function that takes a consistent copy of the statistics of a FIFO, and
+ * computes its ``mean_fill``. It may be called from any thread. If
+ * statistics are not enabled the copy is cleared.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   copy                Where the statistics are copied to
+ */
+void asynchronous_fifo_get_stats(asynchronous_fifo_t * UNSAFE state,
+                                 asynchronous_fifo_stats_t * UNSAFE copy);
+
+/**
+ * Function that sets the scale factor used by asynchronous_fifo_scale_timestamp(),
+ * for systems whose timestamps do not come from the 100 MHz reference
+ * clock, eg, PTP time shared between chips. The default is 1.0, for
+ * 64-bit reference clock timestamps. On a broadcast FIFO the scale
+ * is set for all consumers.
+ *
+ * It should be called by the producer, after the FIFO is initialised and
+ * before any timestamps are scaled.
+ *
+ * @param   state               Asynchronous FIFO
+ *
+ * @param   scale               Reference clock ticks per timestamp unit, as
+ *                              an unsigned 32.32 fixed point number, see
+ *                              ASYNCHRONOUS_FIFO_TIMESTAMP_SCALE().
+ */
+void asynchronous_fifo_init_timestamp_scale(asynchronous_fifo_t * UNSAFE state,
+                                            uint64_t scale);
+
+/**
+ * Function that converts a 64-bit timestamp into the 32-bit reference clock
+ * ticks taken by asynchronous_fifo_producer_put(), asynchronous_fifo_producer_put_fract()
+ * and asynchronous_fifo_consumer_get(). The timestamp is multiplied by the
+ * scale set with asynchronous_fifo_init_timestamp_scale() and the result
+ * is taken modulo 2^32 ticks; as the 64-bit timestamp does not wrap, the
+ * result wraps exactly as the reference clock does, whatever the scale.
+ * Both sides must scale their timestamps for the FIFO to compare them.
+ *
+ * @param   state               Asynchronous FIFO, or the consumer of a
+ *                              broadcast FIFO
+ *
+ * @param   timestamp           64-bit timestamp, eg, PTP nanoseconds.
+ *
+ * @param   fract               Set to the fraction of a tick, as an unsigned
+ *                              0.32 fixed point number, for
+ *                              asynchronous_fifo_producer_put_fract(). If NULL
+ *                              the result is rounded to the nearest tick.
+ *
+ * @returns The timestamp in whole reference clock ticks
+ */
+int32_t asynchronous_fifo_scale_timestamp(asynchronous_fifo_t * UNSAFE state,
+                                          uint64_t timestamp,
+                                          uint32_t * UNSAFE fract);
+
 /**
  * Function that that resets the FIFO from the producer side. Either this function should
  * be called on the producing side, or ``asynchronous_fifo_reset_consumer``
@@ -167,7 +525,12 @@ void asynchronous_fifo_exit(asynchronous_fifo_t * UNSAFE state);
  * It is probably fine to use the reference clocks on two tiles, provided
  * the tiles came out of reset at more or less the same time. Using the
  * clocks from two different chips would require the two chips to share an
- * oscillator, and for them to come out of reset simultaneously.
+ * oscillator, and for them to come out of reset simultaneously, or a
+ * shared time such as PTP converted with asynchronous_fifo_scale_timestamp().
+ *
+ * Timestamps are 32-bit tick counts that may wrap; the FIFO only uses the
+ * differences between them modulo 2^32, so the wrap of the reference clock
+ * every 43 seconds is not seen.
  *
  * @param   state               ASRC structure to push the sample into
  *
@@ -194,6 +557,40 @@ int32_t asynchronous_fifo_producer_put(asynchronous_fifo_t * UNSAFE state,
                                        int32_t timestamp);
 
 
+/**
+ * Function that provides the next samples to the asynchronous FIFO, with a
+ * timestamp that has sub-tick resolution, such as the one produced by
+ * asrc_timestamp_interpolation_fract(). It is otherwise the same as
+ * asynchronous_fifo_producer_put().
+ *
+ * The phase detector resolves 1/2^ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS of a
+ * tick and averages the phase error over all ``n`` samples instead of only
+ * using the last one, which reduces the dither on the returned ratio when
+ * there are few ticks per sample (eg, 521 at 192 kHz). The consumer side is
+ * unchanged. A FIFO should be fed by either this function or
+ * asynchronous_fifo_producer_put(), not a mix of both.
+ *
+ * @param   state               ASRC structure to push the sample into
+ *
+ * @param   samples             The sample values.
+ *
+ * @param   n                   The number of samples
+ *
+ * @param   timestamp           The number of ticks when this sample was input.
+ *
+ * @param   timestamp_fract     The fraction of a tick to add to timestamp,
+ *                              as an unsigned 0.32 fixed point number.
+ *
+ * @returns The current estimate of the mismatch of input and output
+ *          frequencies, as for asynchronous_fifo_producer_put()
+ */
+int32_t asynchronous_fifo_producer_put_fract(asynchronous_fifo_t * UNSAFE state,
+                                             int32_t * UNSAFE samples,
+                                             int n,
+                                             int32_t timestamp,
+                                             uint32_t timestamp_fract);
+
+
 /**
  * Return code for asynchronous_fifo_consumer_get()
  */
@@ -224,11 +621,82 @@ asynchronous_fifo_get_return_t asynchronous_fifo_consumer_get(asynchronous_fifo_
                                                                 int32_t timestamp);
 
 
+/**
+ * Function that gets ``n`` output frames from the asynchronous FIFO in one
+ * call. It is equivalent to calling asynchronous_fifo_consumer_get() ``n``
+ * times, but the frames are copied with at most two block copies (or one pass
+ * for a planar destination) and the caller only supplies a single timestamp.
+ * The timestamps that the PID needs for the intermediate frames are spread
+ * linearly between the previous get and this one.
+ *
+ * The frames are consumed, and the read position published to the producer,
+ * only after all ``n`` frames have been copied out. If fewer than ``n + 2``
+ * frames are available nothing is consumed, ``ASYNCH_FIFO_UNDERFLOW`` is
+ * returned and, as for asynchronous_fifo_consumer_get(), all ``n`` output
+ * frames repeat the frame at the read position.
+ *
+ * @param   state               ASRC structure to read the frames out off.
+ *
+ * @param   samples             The array where the output frames will be
+ *                              stored.
+ *
+ * @param   n                   The number of frames to get. Must be at least 1
+ *                              and less than ``max_fifo_depth - 2``.
+ *
+ * @param   timestamp           A timestamp taken at the time that the
+ *                              last of the ``n`` frames was output. See
+ *                              ``asynchronous_fifo_produce`` for requirements.
+ *
+ * @param   planar_stride       0 to store the frames interleaved, ie,
+ *                              ``samples[frame * channel_count + channel]``.
+ *                              Otherwise the frames are stored planar, with
+ *                              ``samples[channel * planar_stride + frame]``;
+ *                              ``planar_stride`` must be at least ``n``.
+ *
+ * @returns The FIFO status and whether the samples are valid or not
+ */
+asynchronous_fifo_get_return_t asynchronous_fifo_consumer_get_bulk(asynchronous_fifo_t * UNSAFE state,
+                                                                     int32_t * UNSAFE samples,
+                                                                     int n,
+                                                                     int32_t timestamp,
+                                                                     int planar_stride);
+
+
 /**
  * macro that calculates the number of int64_t to be allocated for the fifo
  * for a FIFO of N elements and C channels
  */
 #define ASYNCHRONOUS_FIFO_INT64_ELEMENTS(N, C) (sizeof(asynchronous_fifo_t)/sizeof(int64_t) + (N*(C+1))/2+1)
+
+/**
+ * macro that calculates the number of words used by one frame of C channels
+ * stored in format F
+ */
+#define ASYNCHRONOUS_FIFO_FRAME_WORDS(C, F) (((C)*(F)+3)/4)
+
+/**
+ * macro that calculates the number of int64_t to be allocated for a fifo
+ * of N elements and C channels, stored in format F with one timestamp per K
+ * elements
+ */
+#define ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(N, C, F, K) (sizeof(asynchronous_fifo_t)/sizeof(int64_t) + \
+    ((N)*ASYNCHRONOUS_FIFO_FRAME_WORDS(C, F) + ((N)+(K)-1)/(K))/2+1)
+
+/**
+ * macro that calculates the number of int64_t used by each consumer after
+ * the first of a broadcast fifo of N elements with one timestamp per K
+ * elements
+ */
+#define ASYNCHRONOUS_FIFO_CONSUMER_INT64_ELEMENTS(N, K) (sizeof(asynchronous_fifo_t)/sizeof(int64_t) + \
+    (((N)+(K)-1)/(K))/2+1)
+
+/**
+ * macro that calculates the number of int64_t to be allocated for a
+ * broadcast fifo of N elements and C channels with M consumers, stored in
+ * format F with one timestamp per K elements
+ */
+#define ASYNCHRONOUS_FIFO_BROADCAST_INT64_ELEMENTS(N, C, F, K, M) (ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(N, C, F, K) + \
+    ((M)-1)*ASYNCHRONOUS_FIFO_CONSUMER_INT64_ELEMENTS(N, K))
 #endif
 
 /**@}*/ // END: addtogroup src_fifo
@@ -83,6 +83,27 @@ uint64_t asrc_init(const fs_code_t sr_in, const fs_code_t sr_out,
                    asrc_ctrl_t asrc_ctrl[], const unsigned n_channels_per_instance,
                    const unsigned n_in_samples, const dither_flag_t dither_on_off);
 
+/** initializes asynchronous sample rate conversion instance using caller provided memory.
+ *
+ *  Same as asrc_init() except that the state, stack and adaptive filter coefficients are taken
+ *  from the arena rather than being set in each control structure beforehand. This allows the
+ *  block size to be chosen at run time, the arena only needs to be large enough for it.
+ *
+ *  \param   sr_in                    Nominal sample rate code of input stream
+ *  \param   sr_out                   Nominal sample rate code of output stream
+ *  \param   asrc_ctrl                Reference to array of ASRC control structures
+ *  \param   n_channels_per_instance  Number of channels handled by this instance of ASRC
+ *  \param   n_in_samples             Number of input samples per ASRC call (multiple of 4)
+ *  \param   dither_on_off            Dither to 24b on/off
+ *  \param   arena                    64b aligned memory, at least ASRC_ARENA_BYTES(n_channels_per_instance, n_in_samples) bytes
+ *  \param   arena_bytes              Size of the arena in bytes
+ *  \returns The nominal sample rate ratio of in to out in Q4.60 format
+ */
+uint64_t asrc_init_arena(const fs_code_t sr_in, const fs_code_t sr_out,
+                         asrc_ctrl_t asrc_ctrl[], const unsigned n_channels_per_instance,
+                         const unsigned n_in_samples, const dither_flag_t dither_on_off,
+                         long long arena[], const unsigned arena_bytes);
+
 /** Perform asynchronous sample rate conversion processing on block of input samples using previously initialized settings.
  *
  *  \param   in_buff          Reference to input sample buffer array
@@ -94,6 +115,28 @@ uint64_t asrc_init(const fs_code_t sr_in, const fs_code_t sr_out,
 unsigned asrc_process(int in_buff[], int out_buff[], uint64_t fs_ratio,
                       asrc_ctrl_t asrc_ctrl[]);
 
+/** Perform asynchronous sample rate conversion processing on the channels of this instance within wider frames.
+ *
+ *  Same as asrc_process() except that the input and output frames may hold more channels than this
+ *  instance, so several instances can read and write shared frames in place. Channel ch of input
+ *  sample n is read from in_buff[n * in_stride + channel_offset + ch], and channel ch of output
+ *  sample n is written to out_buff[n * out_stride + channel_offset + ch].
+ *  asrc_process() is the same as a call with a channel_offset of 0 and both strides equal to the
+ *  number of channels of the instance.
+ *
+ *  \param   in_buff          Reference to input sample buffer array
+ *  \param   out_buff         Reference to output sample buffer array
+ *  \param   fs_ratio         Fixed point ratio of in/out sample rates in Q4.60 format
+ *  \param   asrc_ctrl        Reference to array of ASRC control structures
+ *  \param   channel_offset   Index within each frame of the first channel of this instance
+ *  \param   in_stride        Number of words per input frame, at least channel_offset plus the channel count
+ *  \param   out_stride       Number of words per output frame, at least channel_offset plus the channel count
+ *  \returns The number of output samples produced by the SRC operation.
+ */
+unsigned asrc_process_strided(int in_buff[], int out_buff[], uint64_t fs_ratio,
+                              asrc_ctrl_t asrc_ctrl[], unsigned channel_offset,
+                              unsigned in_stride, unsigned out_stride);
+
 /**@}*/ // END: addtogroup src_asrc
 
 
@@ -116,11 +159,11 @@ typedef struct src_ds3_ctrl_t
 {
     int*         in_data;      //!< Pointer to input data (3 samples)
     int*         out_data;     //!< Pointer to output data (1 sample)
-    int*         delay_base;   //!< Pointer to delay line base
-    unsigned int delay_len;    //!< Total length of delay line
-    int*         delay_pos;    //!< Pointer to current position in delay line
-    int*         delay_wrap;   //!< Delay buffer wrap around address (for circular buffer simulation)
-    unsigned int delay_offset; //!< Delay line offset for second write (for circular buffer simulation)
+    int*         delay_base;   //!< Pointer to delay line base (SRC_FF3_DS3_DELAY_LEN words)
+    unsigned int delay_len;    //!< Total length of delay line (filter window plus slack)
+    int*         delay_pos;    //!< Pointer to start of the filter window in delay line
+    int*         delay_wrap;   //!< Last window start before the window is moved back to the base
+    unsigned int delay_offset; //!< Filter window length, offset of the write position from delay_pos
     unsigned int inner_loops;  //!< Number of inner loop iterations
     unsigned int num_coeffs;   //!< Number of coefficients
     int*         coeffs;       //!< Pointer to coefficients
@@ -154,11 +197,11 @@ typedef struct src_os3_ctrl_t
     int          in_data;      //!< Input data (to be updated every 3 output samples, i.e. when iPhase == 0)
     int          out_data;     //!< Output data (1 sample)
     int          phase;        //!< Current output phase (when reaching '0', a new input sample is required)
-    int*         delay_base;   //!< Pointer to delay line base
-    unsigned int delay_len;    //!< Total length of delay line
-    int*         delay_pos;    //!< Pointer to current position in delay line
-    int*         delay_wrap;   //!< Delay buffer wrap around address (for circular buffer simulation)
-    unsigned int delay_offset; //!< Delay line offset for second write (for circular buffer simulation)
+    int*         delay_base;   //!< Pointer to delay line base (SRC_FF3_OS3_DELAY_LEN words)
+    unsigned int delay_len;    //!< Total length of delay line (filter window plus slack)
+    int*         delay_pos;    //!< Pointer to start of the filter window in delay line
+    int*         delay_wrap;   //!< Last window start before the window is moved back to the base
+    unsigned int delay_offset; //!< Filter window length, offset of the write position from delay_pos
     unsigned int inner_loops;  //!< Number of inner loop iterations
     unsigned int num_coeffs;   //!< Number of coefficients
     int*         coeffs;       //!< Pointer to coefficients
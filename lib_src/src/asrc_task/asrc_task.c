@@ -12,6 +12,7 @@
 #include <xcore/interrupt.h>
 #include <xcore/interrupt_wrappers.h>
 #include <xcore/triggerable.h>
+#include <xcore/thread.h>
 
 #include <stdio.h>
 #include <print.h>
@@ -21,6 +22,7 @@
 
 #include "asrc_task.h"
 #include "asrc_timestamp_interpolation.h"
+#include "asrc_task_schedule.h"
 
 #ifdef DEBUG_ASRC_TASK
 #define dprintf(...)   printf(__VA_ARGS__)
@@ -49,60 +51,21 @@ static int frequency_to_fs_code(int frequency) {
 }
 
 
-// Structure used for thread scheduling of parallel ASRC
-typedef struct schedule_info_t{
-    int num_channels;
-    int channel_start_idx;
-} schedule_info_t;
-
-
-// Generates a schedule based on the number of channels of ASRC needed vs available threads
-int calculate_job_share(int asrc_channel_count,
-                        schedule_info_t *schedule){
-    int channels_per_first_job = (asrc_channel_count + MAX_ASRC_THREADS - 1) / MAX_ASRC_THREADS; // Rounded up channels per max jobs
-    int channels_per_last_job = 0;
-
-    int num_jobs = 0;
-    while(asrc_channel_count > 0){
-        channels_per_last_job = asrc_channel_count;
-        asrc_channel_count -= channels_per_first_job;
-        schedule[num_jobs].num_channels = channels_per_first_job;
-        schedule[num_jobs].channel_start_idx = channels_per_first_job * num_jobs;
-        num_jobs++;
-    };
-    schedule[num_jobs - 1].num_channels = channels_per_last_job;
-
-    return num_jobs;
-}
+// ASRC memory of one instance, for the largest block size
+#define ASRC_TASK_ARENA_BYTES   ASRC_ARENA_BYTES(SRC_MAX_SRC_CHANNELS_PER_INSTANCE, SRC_N_IN_SAMPLES)
 
 
 // A single worker thread which operates on a group of channels in parallel with other worker threads
 DECLARE_JOB(do_asrc_group, (schedule_info_t*, uint64_t, asrc_in_out_t*, unsigned, int*, asrc_ctrl_t*));
 void do_asrc_group(schedule_info_t *schedule, uint64_t fs_ratio, asrc_in_out_t * asrc_io, unsigned input_write_idx, int* num_output_samples, asrc_ctrl_t asrc_ctrl[]){
 
-    // Make copies for readability
-    int num_worker_channels = schedule->num_channels;
+    // Make copies for readability. The channel count is set in asrc_ctrl by asrc_init()
     int worker_channel_start_idx = schedule->channel_start_idx;
 
-    // Pack into the frame this instance of ASRC expects
-    int input_samples[ASRC_N_IN_SAMPLES * MAX_ASRC_CHANNELS_TOTAL];
-    for(int i = 0; i < ASRC_N_IN_SAMPLES * num_worker_channels; i++){
-        // int rd_idx = i % num_worker_channels + (i / num_worker_channels) * asrc_io->asrc_channel_count + worker_channel_start_idx;
-        int rd_idx = i + (asrc_io->asrc_channel_count - num_worker_channels) * (i / num_worker_channels) + worker_channel_start_idx; // Optimisation of above
-        input_samples[i] = asrc_io->input_samples[input_write_idx][rd_idx];
-    }
-
-    // Declare output buffer suitable for this instance
-    int output_samples[SRC_MAX_NUM_SAMPS_OUT * MAX_ASRC_CHANNELS_TOTAL];
-    // Do the ASRC for this group of samples
-    *num_output_samples = asrc_process(input_samples, output_samples, fs_ratio, asrc_ctrl);
-
-    // Unpack to combined output frame
-    for(int i = 0; i < *num_output_samples * num_worker_channels; i++){
-        // int wr_idx = i % num_worker_channels + (i / num_worker_channels) * asrc_io->asrc_channel_count + worker_channel_start_idx;
-        int wr_idx = i + (asrc_io->asrc_channel_count - num_worker_channels) * (i / num_worker_channels) + worker_channel_start_idx; // Optimisation of above
-        asrc_io->output_samples[wr_idx] = output_samples[i];
-    }
+    // Do the ASRC for this group of channels, reading and writing the shared frames in place
+    *num_output_samples = asrc_process_strided((int *)asrc_io->input_samples[input_write_idx], (int *)asrc_io->output_samples,
+                                               fs_ratio, asrc_ctrl, worker_channel_start_idx,
+                                               asrc_io->asrc_channel_count, asrc_io->asrc_channel_count);
 }
 
 
@@ -180,6 +143,97 @@ int par_asrc(int num_jobs, schedule_info_t schedule[], uint64_t fs_ratio, asrc_i
 }
 
 
+#if ASRC_TASK_PERSISTENT_WORKERS
+// The block of work shared by asrc_processor and the persistent workers. It is written before the
+// workers are started on a block and only read by them until they report back.
+typedef struct asrc_worker_job_t{
+    schedule_info_t *schedule;
+    uint64_t fs_ratio;
+    asrc_in_out_t *asrc_io;
+    unsigned input_write_idx;
+    asrc_ctrl_t (*asrc_ctrl)[SRC_MAX_SRC_CHANNELS_PER_INSTANCE];
+} asrc_worker_job_t;
+
+// One persistent worker, which runs job instance of each block
+typedef struct asrc_worker_t{
+    chanend_t c_job;            // Receives a token to start a block and sends one back when it is done
+    int instance;
+    asrc_worker_job_t *job;
+} asrc_worker_t;
+
+// Persistent workers, started once. Worker 0 is never started, asrc_processor runs job 0 itself.
+typedef struct asrc_workers_t{
+    asrc_worker_job_t job;
+    asrc_worker_t worker[MAX_ASRC_THREADS];
+    chanend_t c_job[MAX_ASRC_THREADS];      // The asrc_processor end of each worker's channel
+} asrc_workers_t;
+
+static uint64_t asrc_worker_stack[MAX_ASRC_THREADS - 1][ASRC_TASK_WORKER_STACK_WORDS / 2];
+
+// Body of a persistent worker thread, waits for a block and runs its share of the channels, forever
+void asrc_worker(void *arg){
+    asrc_worker_t *worker = arg;
+    int num_output_samples;
+
+    while(1){
+        chanend_in_byte(worker->c_job);
+        asrc_worker_job_t *job = worker->job;
+        do_asrc_group(&job->schedule[worker->instance], job->fs_ratio, job->asrc_io, job->input_write_idx,
+                      &num_output_samples, job->asrc_ctrl[worker->instance]);
+        chanend_out_byte(worker->c_job, 0);
+    }
+}
+
+// Starts MAX_ASRC_THREADS - 1 workers, each waiting on a streaming channel to asrc_processor
+static void asrc_workers_start(asrc_workers_t *workers){
+    unsigned stack_words;
+    asm("ldc %0, asrc_worker.nstackwords" : "=r" (stack_words));
+    xassert(stack_words <= ASRC_TASK_WORKER_STACK_WORDS); // Increase ASRC_TASK_WORKER_STACK_WORDS
+
+    threadgroup_t group = thread_group_alloc();
+    xassert(group != 0); // No synchroniser free for the worker group
+    for(int i = 1; i < MAX_ASRC_THREADS; i++){
+        asrc_worker_t *worker = &workers->worker[i];
+        workers->c_job[i] = chanend_alloc();
+        worker->c_job = chanend_alloc();
+        xassert(workers->c_job[i] != 0 && worker->c_job != 0); // Not enough chanends for the workers
+        chanend_set_dest(workers->c_job[i], worker->c_job);
+        chanend_set_dest(worker->c_job, workers->c_job[i]);
+        worker->instance = i;
+        worker->job = &workers->job;
+        xthread_t thread = thread_group_add(group, asrc_worker, worker, stack_base(asrc_worker_stack[i - 1], ASRC_TASK_WORKER_STACK_WORDS));
+        xassert(thread != 0); // Not enough threads for MAX_ASRC_THREADS
+    }
+    thread_group_start(group);
+}
+
+// Runs a block on the persistent workers: the same as par_asrc() for any number of jobs, without forking threads
+int persistent_par_asrc(asrc_workers_t *workers, int num_jobs, schedule_info_t schedule[], uint64_t fs_ratio, asrc_in_out_t * asrc_io, unsigned input_write_idx, asrc_ctrl_t asrc_ctrl[MAX_ASRC_THREADS][SRC_MAX_SRC_CHANNELS_PER_INSTANCE]){
+    int num_output_samples = 0;
+
+    xassert(num_jobs <= MAX_ASRC_THREADS); // Too many jobs specified
+    if(num_jobs == 0){
+        return 0; // Nothing to do
+    }
+    workers->job.schedule = schedule;
+    workers->job.fs_ratio = fs_ratio;
+    workers->job.asrc_io = asrc_io;
+    workers->job.input_write_idx = input_write_idx;
+    workers->job.asrc_ctrl = asrc_ctrl;
+
+    for(int i = 1; i < num_jobs; i++){
+        chanend_out_byte(workers->c_job[i], 0);
+    }
+    do_asrc_group(&schedule[0], fs_ratio, asrc_io, input_write_idx, &num_output_samples, asrc_ctrl[0]);
+    for(int i = 1; i < num_jobs; i++){
+        chanend_in_byte(workers->c_job[i]);
+    }
+
+    return num_output_samples;
+}
+#endif
+
+
 // Called from consumer side. Produces samples and returns channel count
 int pull_samples(asrc_in_out_t * asrc_io, asynchronous_fifo_t * fifo, int32_t *samples, uint32_t output_frequency, int32_t consume_timestamp){
     asrc_io->output_frequency = output_frequency;
@@ -197,13 +251,17 @@ int pull_samples(asrc_in_out_t * asrc_io, asynchronous_fifo_t * fifo, int32_t *s
 // Consumer side FIFO reset and clear contents
 void reset_asrc_fifo_consumer(asynchronous_fifo_t * fifo){
     asynchronous_fifo_reset_consumer(fifo);
-    memset(fifo->buffer, 0, fifo->channel_count * fifo->max_fifo_depth * sizeof(int));
+    // The frames of a broadcast FIFO are still being played by the other consumers
+    if (fifo->consumer_count <= 1){
+        memset(fifo->buffer, 0, fifo->frame_words * fifo->max_fifo_depth * sizeof(int));
+    }
 }
 
 // Default implementation of receive (called from ASRC) which receives samples and config over a channel. This is overridable.
 ASRC_TASK_ISR_CALLBACK_ATTR
 unsigned receive_asrc_input_samples_cb_default(chanend_t c_asrc_input, asrc_in_out_t *asrc_io, unsigned *new_input_rate){
-    static unsigned asrc_in_counter = 0;
+    // Kept per stream as this may be called for several streams
+    unsigned asrc_in_counter = asrc_io->input_sample_counter;
 
     // Get format and timing data from channel
     *new_input_rate = chanend_in_word(c_asrc_input);
@@ -216,9 +274,10 @@ unsigned receive_asrc_input_samples_cb_default(chanend_t c_asrc_input, asrc_in_o
         asrc_io->input_samples[asrc_io->input_write_idx][idx] = chanend_in_word(c_asrc_input);
     }
 
-    if(++asrc_in_counter == SRC_N_IN_SAMPLES){
+    if(++asrc_in_counter >= asrc_io->input_block_size){
         asrc_in_counter = 0;
     }
+    asrc_io->input_sample_counter = asrc_in_counter;
 
     return asrc_in_counter;
 }
@@ -230,6 +289,7 @@ typedef struct asrc_receive_samples_ctx_t{
     chanend_t c_asrc_input; // The chanend from which samples are received (streaming)
     chanend_t c_buff_idx;   // The chanend used to notify asrc_processor that a new block of samples is available
     asrc_in_out_t *asrc_io; // The ASRC IO state including buffers
+    unsigned stream_idx;    // The stream of asrc_processor the samples belong to
 } asrc_receive_samples_ctx_t;
 
 // This is fired each time a sample is received (triggered by first channel token)
@@ -252,32 +312,53 @@ DEFINE_INTERRUPT_CALLBACK(ASRC_ISR_GRP, asrc_samples_rx_isr_handler, app_data){
         // Note if you ever find the code has stopped here then this is due to the time required to ASRC process the input frame
         // is longer than the period of the frames coming in. To remedy this you need to increase ASRC processing resources or reduce
         // the processing requirement. If you are using xcore-200, consider using xcore.ai for more than 2x the ASRC performance.
-        // Notify ASRC main loop of new frame
-        chanend_out_byte(c_buff_idx, (uint8_t)asrc_io->input_write_idx);
+        // Notify ASRC main loop of new frame, bit 0 is the buffer and the rest the stream
+        chanend_out_byte(c_buff_idx, (uint8_t)((asrc_receive_samples_ctx->stream_idx << 1) | asrc_io->input_write_idx));
         asrc_io->input_write_idx ^= 1; // Swap buffers
     }
 }
 
 
-// Keep receiving samples until input format is good
-static inline void asrc_wait_for_valid_config(chanend_t c_buff_idx, uint32_t *input_frequency, uint32_t *output_frequency, volatile asrc_in_out_t *asrc_io){
-    asrc_io->ready_flag_to_receive = 1; // Signal we are ready to consume a frame of input samples
-
-    do{
-        chanend_in_byte(c_buff_idx); // Receive frame from source (receive_asrc_input_samples_cb)
-        *input_frequency = asrc_io->input_frequency; // Extract input rate
-        asrc_io->asrc_channel_count = asrc_io->input_channel_count; // Extract input channel count
-        *output_frequency = asrc_io->output_frequency;
-
-    } while(*input_frequency == 0 ||
-            *output_frequency == 0 ||
-            asrc_io->asrc_channel_count == 0);
+// State of one input stream of asrc_processor, kept from block to block. All streams share the worker threads.
+typedef struct asrc_stream_t{
+    asrc_receive_samples_ctx_t rx_ctx;  // Passed to the ISR, also holds the input channel and the IO state of the stream
+    asynchronous_fifo_t *fifo;          // The output FIFO of the stream
+    bool configured;                    // Set while the ASRC and FIFO are initialised for the current format
+    uint32_t input_frequency;
+    uint32_t output_frequency;
+    int interpolation_ticks;
+    schedule_info_t schedule[MAX_ASRC_THREADS];
+    int num_jobs;
+    uint64_t fs_ratio;
+    int ideal_fs_ratio;
+    int error;
+    int32_t asrc_process_time_limit;    // Timing check vars. Includes ASRC, timestamp interpolation and FIFO push
+    int32_t asrc_peak_processing_time;
+    // State, stack and coefficients of each instance come from its arena, sized for the largest block
+    long long asrc_arena[MAX_ASRC_THREADS][ASRC_TASK_ARENA_BYTES / sizeof(long long)];  // ASRC memory
+    asrc_ctrl_t sASRCCtrl[MAX_ASRC_THREADS][SRC_MAX_SRC_CHANNELS_PER_INSTANCE];         // Control structure
+} asrc_stream_t;
+
+
+// Check the input format of a stream after receiving a block, returns true once it is good
+static inline bool asrc_check_valid_config(asrc_stream_t *stream){
+    volatile asrc_in_out_t *asrc_io = stream->rx_ctx.asrc_io;
+
+    stream->input_frequency = asrc_io->input_frequency; // Extract input rate
+    asrc_io->asrc_channel_count = asrc_io->input_channel_count; // Extract input channel count
+    stream->output_frequency = asrc_io->output_frequency;
+
+    if(stream->input_frequency == 0 ||
+       stream->output_frequency == 0 ||
+       asrc_io->asrc_channel_count == 0){
+        return false;
+    }
 
     xassert(asrc_io->asrc_channel_count <= MAX_ASRC_CHANNELS_TOTAL); // Too many channels requested
-    frequency_to_fs_code(*input_frequency);  // This will assert if invalid
-    frequency_to_fs_code(*output_frequency); // This will assert if invalid
+    frequency_to_fs_code(stream->input_frequency);  // This will assert if invalid
+    frequency_to_fs_code(stream->output_frequency); // This will assert if invalid
 
-    asrc_io->ready_flag_to_receive = 0;
+    return true;
 }
 
 
@@ -294,15 +375,13 @@ static inline bool asrc_detect_format_change(uint32_t input_frequency, uint32_t
 }
 
 
-// Main ASRC task. Defined as ISR friendly because we interrupt it receive samples
-DEFINE_INTERRUPT_PERMITTED(ASRC_ISR_GRP, void, asrc_processor,
-                            chanend_t c_asrc_input,
-                            asrc_in_out_t *asrc_io,
-                            chanend_t c_buff_idx,
-                            asynchronous_fifo_t * fifo){
-
-    uint32_t input_frequency = 0;   // Set to invalid for now. We will get rates supplied by producer and consumer.
-    uint32_t output_frequency = 0;
+// Initialise the FIFO, schedule and ASRC instances of a stream for its current format. With keep_fifo set the
+// output rate and channel count have not changed, so the FIFO keeps playing and only its PID gains follow the input rate.
+static void asrc_stream_configure(asrc_stream_t *stream, bool keep_fifo){
+    asrc_in_out_t *asrc_io = stream->rx_ctx.asrc_io;
+    asynchronous_fifo_t *fifo = stream->fifo;
+    uint32_t input_frequency = stream->input_frequency;
+    uint32_t output_frequency = stream->output_frequency;
 
     // Used for calculating the timestamp interpolation between major frequency conversions
     const int interpolation_ticks_2D[6][6] = {
@@ -314,121 +393,210 @@ DEFINE_INTERRUPT_PERMITTED(ASRC_ISR_GRP, void, asrc_processor,
         {  2083, 2083, 1042, 1042,  521,  521}
     };
 
-    // Setup a pointer to a struct so the ISR can access these elements
-    asrc_receive_samples_ctx_t asrc_receive_samples_ctx = {c_asrc_input, c_buff_idx, asrc_io};
+    asrc_io->ready_flag_to_receive = 0;
 
-    // Enable interrupt on channel receive token (sent from ISR)
-    triggerable_setup_interrupt_callback(c_asrc_input, &asrc_receive_samples_ctx, INTERRUPT_CALLBACK(asrc_samples_rx_isr_handler));
-    triggerable_enable_trigger(c_asrc_input);
-    interrupt_unmask_all();
+    //// Extract frequency info
+    dprintf("Input fs: %lu Output fs: %lu\n", input_frequency, output_frequency);
+    int inputFsCode = frequency_to_fs_code(input_frequency);
+    int outputFsCode = frequency_to_fs_code(output_frequency);
+    stream->interpolation_ticks = interpolation_ticks_2D[inputFsCode][outputFsCode];
 
-    // This is a forever loop consisting of init -> forever process, until format change when we return to init
-    while(1){
-        asrc_wait_for_valid_config(c_buff_idx, &input_frequency, &output_frequency, asrc_io);
-
-        //// Extract frequency info
-        dprintf("Input fs: %lu Output fs: %lu\n", input_frequency, output_frequency);
-        int inputFsCode = frequency_to_fs_code(input_frequency);
-        int outputFsCode = frequency_to_fs_code(output_frequency);
-        int interpolation_ticks = interpolation_ticks_2D[inputFsCode][outputFsCode];
+    if (!keep_fifo){
+        stream->error = 0; // A new FIFO starts from the nominal ratio
+    }
 
-        //// FIFO init
+    //// FIFO init
+    int settle_puts = input_frequency * ASRC_TASK_PID_SETTLE_MS / (1000 * asrc_io->input_block_size);
+    if (keep_fifo){
+        // Boost the PID again, if enabled, to take up the change in filter delay, its ratio carries on from the old rate
+        for(asynchronous_fifo_t *consumer = fifo; consumer != NULL; consumer = consumer->next_consumer){
+            asynchronous_fifo_init_PID_fs_codes(consumer, inputFsCode, outputFsCode);
+            asynchronous_fifo_init_PID_schedule(consumer, ASRC_TASK_PID_GAIN_BOOST, ASRC_TASK_PID_SETTLE_TICKS, settle_puts);
+        }
+    } else {
         dprintf("FIFO init channels: %d length: %ld\n", asrc_io->asrc_channel_count, fifo->max_fifo_depth);
-        asynchronous_fifo_init(fifo, asrc_io->asrc_channel_count, fifo->max_fifo_depth);
-        asynchronous_fifo_init_PID_fs_codes(fifo, inputFsCode, outputFsCode);
-
-        //// Parallel scheduler init
-        schedule_info_t schedule[MAX_ASRC_THREADS];
-        int num_jobs = calculate_job_share(asrc_io->asrc_channel_count, schedule);
-        dprintf("num_jobs: %d, MAX_ASRC_THREADS: %d, asrc_channel_count: %d\n", num_jobs, MAX_ASRC_THREADS, asrc_io->asrc_channel_count);
-        for(int i = 0; i < num_jobs; i++){
-            dprintf("schedule: %d, num_channels: %d, channel_start_idx: %d\n", i, schedule[i].num_channels, schedule[i].channel_start_idx);
+        if (asrc_io->fifo_consumer_count > 1){
+            asynchronous_fifo_broadcast_init(fifo, asrc_io->fifo_consumer_count, asrc_io->asrc_channel_count, fifo->max_fifo_depth,
+                                             ASYNCH_FIFO_FORMAT_INT32, 1);
+        } else {
+            asynchronous_fifo_init(fifo, asrc_io->asrc_channel_count, fifo->max_fifo_depth);
         }
-        int max_channels_per_instance = schedule[0].num_channels;
-        dprintf("max_channels_per_instance: %d\n", max_channels_per_instance);
-
-        //// ASRC init
-        asrc_state_t sASRCState[MAX_ASRC_THREADS][SRC_MAX_SRC_CHANNELS_PER_INSTANCE];                                   // ASRC state machine state
-        int iASRCStack[MAX_ASRC_THREADS][SRC_MAX_SRC_CHANNELS_PER_INSTANCE][ASRC_STACK_LENGTH_MULT * SRC_N_IN_SAMPLES ];// Buffer between filter stages
-        asrc_ctrl_t sASRCCtrl[MAX_ASRC_THREADS][SRC_MAX_SRC_CHANNELS_PER_INSTANCE];                                     // Control structure
-        asrc_adfir_coefs_t asrc_adfir_coefs[MAX_ASRC_THREADS];                                                          // Adaptive filter coefficients
-
-        uint64_t fs_ratio = 0;
-        int ideal_fs_ratio = 0;
-        int error = 0;
-
-        for(int instance = 0; instance < num_jobs; instance++){
-            for(int ch = 0; ch < max_channels_per_instance; ch++){
-                // Set state, stack and coefs into ctrl structure
-                sASRCCtrl[instance][ch].psState                   = &sASRCState[instance][ch];
-                sASRCCtrl[instance][ch].piStack                   = iASRCStack[instance][ch];
-                sASRCCtrl[instance][ch].piADCoefs                 = asrc_adfir_coefs[instance].iASRCADFIRCoefs;
+        // Optionally start with a boosted PID so the FIFO reaches its midpoint quickly, then settle to the low jitter gains
+        int adaptive_window_puts = input_frequency * ASRC_TASK_FIFO_ADAPTIVE_WINDOW_MS / (1000 * asrc_io->input_block_size);
+        asynchronous_fifo_stats_t *fifo_stats = asrc_io->fifo_stats;
+        for(asynchronous_fifo_t *consumer = fifo; consumer != NULL; consumer = consumer->next_consumer){
+            if (fifo_stats != NULL){
+                asynchronous_fifo_enable_stats(consumer, fifo_stats++);
             }
-            fs_ratio = asrc_init(inputFsCode, outputFsCode, sASRCCtrl[instance], max_channels_per_instance, SRC_N_IN_SAMPLES, SRC_DITHER_SETTING);
+            asynchronous_fifo_init_PID_fs_codes(consumer, inputFsCode, outputFsCode);
+            asynchronous_fifo_init_PID_schedule(consumer, ASRC_TASK_PID_GAIN_BOOST, ASRC_TASK_PID_SETTLE_TICKS, settle_puts);
+            asynchronous_fifo_init_adaptive_depth(consumer, ASRC_TASK_FIFO_ADAPTIVE_MARGIN, adaptive_window_puts);
         }
+    }
 
-        //// Timing check vars. Includes ASRC, timestamp interpolation and FIFO push
-        int32_t asrc_process_time_limit = (XS1_TIMER_HZ / input_frequency) * SRC_N_IN_SAMPLES;
-        dprintf("ASRC process_time_limit: %ld\n", asrc_process_time_limit);
-        int32_t asrc_peak_processing_time = 0;
+    //// Parallel scheduler init
+    int num_jobs = calculate_job_share(asrc_io->asrc_channel_count, inputFsCode, outputFsCode, MAX_ASRC_THREADS,
+                                       SRC_MAX_SRC_CHANNELS_PER_INSTANCE, ASRC_TASK_THREAD_MHZ, stream->schedule);
+    stream->num_jobs = num_jobs;
+    dprintf("num_jobs: %d, MAX_ASRC_THREADS: %d, asrc_channel_count: %d\n", num_jobs, MAX_ASRC_THREADS, asrc_io->asrc_channel_count);
+    for(int i = 0; i < num_jobs; i++){
+        dprintf("schedule: %d, num_channels: %d, channel_start_idx: %d\n", i, stream->schedule[i].num_channels, stream->schedule[i].channel_start_idx);
+    }
 
-        ideal_fs_ratio = (fs_ratio + (1<<31)) >> 32;
+    //// ASRC init
+    // Each instance gets its own job's channel count. With an uneven split the later jobs have one channel
+    // fewer and would otherwise process, and write back, channels that belong to the next job.
+    uint64_t fs_ratio = 0;
+    for(int instance = 0; instance < num_jobs; instance++){
+        fs_ratio = asrc_init_arena(inputFsCode, outputFsCode, stream->sASRCCtrl[instance], stream->schedule[instance].num_channels, asrc_io->input_block_size,
+                                   SRC_DITHER_SETTING, stream->asrc_arena[instance], sizeof(stream->asrc_arena[instance]));
+    }
+    stream->ideal_fs_ratio = (fs_ratio + (1<<31)) >> 32;
+    stream->fs_ratio = (((int64_t)stream->ideal_fs_ratio) << 32) + (stream->error * (int64_t) stream->ideal_fs_ratio);
 
-        asrc_io->ready_flag_to_receive = 1; // Signal we are ready to consume a frame of input samples
-        asrc_io->ready_flag_configured = 1; // SIgnal we are ready to produce
+    //// Timing check vars. Includes ASRC, timestamp interpolation and FIFO push
+    stream->asrc_process_time_limit = (XS1_TIMER_HZ / input_frequency) * asrc_io->input_block_size;
+    dprintf("ASRC process_time_limit: %ld\n", stream->asrc_process_time_limit);
+    stream->asrc_peak_processing_time = 0;
 
-        //// Run until format change detected
-        while(1){
-            // Wait for block of samples. We will get the buffer index of the newly written samples from receive_asrc_input_samples_cb
-            unsigned input_write_idx = (unsigned)chanend_in_byte(c_buff_idx);
+    stream->configured = true;
+    asrc_io->ready_flag_to_receive = 1; // Signal we are ready to consume a frame of input samples
+    asrc_io->ready_flag_configured = 1; // SIgnal we are ready to produce
+}
 
-            // Check for format changes - do before we process in case things have changed
-            if(asrc_detect_format_change(input_frequency, output_frequency, asrc_io)){
-                asrc_io->ready_flag_configured = 0;
-                break;
-            }
 
-            int32_t t0 = get_reference_time();
-            int num_output_samples = par_asrc(num_jobs, schedule, fs_ratio, asrc_io, input_write_idx, sASRCCtrl);
-            int ts = asrc_timestamp_interpolation(asrc_io->input_timestamp[input_write_idx], sASRCCtrl[0], interpolation_ticks);
-            // Only push to FIFO if we have samples (FIFO has a bug) otherwise hold last error value
-            if(num_output_samples){
-                error = asynchronous_fifo_producer_put(fifo, &asrc_io->output_samples[0], num_output_samples, ts);
+// Main ASRC task. Defined as ISR friendly because we interrupt it receive samples. Handles num_streams independent
+// streams, each going init -> process until a format change when it returns to init, sharing the worker threads.
+DEFINE_INTERRUPT_PERMITTED(ASRC_ISR_GRP, void, asrc_processor,
+                            chanend_t *c_asrc_input,
+                            asrc_in_out_t **asrc_io,
+                            asynchronous_fifo_t **fifo,
+                            unsigned num_streams){
+
+    // We use a single chanend to send the stream and buffer IDX from the ISRs of this task back to asrc task and sync
+    chanend_t c_buff_idx = chanend_alloc();
+    chanend_set_dest(c_buff_idx, c_buff_idx); // Loopback chanend to itself - we use this as a shallow event driven FIFO
+
+    asrc_stream_t streams[MAX_ASRC_STREAMS];
+
+#if ASRC_TASK_PERSISTENT_WORKERS
+    // The workers outlive every format change, this function never returns
+    asrc_workers_t workers;
+    asrc_workers_start(&workers);
+#endif
+
+    for(int i = 0; i < num_streams; i++){
+        // Setup a pointer to a struct so the ISR can access these elements
+        asrc_stream_t *stream = &streams[i];
+        stream->rx_ctx = (asrc_receive_samples_ctx_t){c_asrc_input[i], c_buff_idx, asrc_io[i], i};
+        stream->fifo = fifo[i];
+        stream->configured = false;
+        stream->error = 0;
+        asrc_io[i]->ready_flag_to_receive = 1; // Signal we are ready to consume a frame of input samples to check the format
+
+        // Enable interrupt on channel receive token (sent from ISR)
+        triggerable_setup_interrupt_callback(c_asrc_input[i], &stream->rx_ctx, INTERRUPT_CALLBACK(asrc_samples_rx_isr_handler));
+        triggerable_enable_trigger(c_asrc_input[i]);
+    }
+    interrupt_unmask_all();
+
+    while(1){
+        // Wait for block of samples. We will get the stream and buffer index of the newly written samples from receive_asrc_input_samples_cb
+        unsigned buff_idx = (unsigned)chanend_in_byte(c_buff_idx);
+        asrc_stream_t *stream = &streams[buff_idx >> 1];
+        unsigned input_write_idx = buff_idx & 1;
+        asrc_in_out_t *stream_io = stream->rx_ctx.asrc_io;
+
+        // Keep receiving samples until input format is good
+        if(!stream->configured){
+            if(asrc_check_valid_config(stream)){
+                asrc_stream_configure(stream, false);
             }
+            continue;
+        }
 
-            fs_ratio = (((int64_t)ideal_fs_ratio) << 32) + (error * (int64_t) ideal_fs_ratio);
-
-            // Watermark for ASRC peak execution time
-            int32_t t1 = get_reference_time();
-            if(t1 - t0 > asrc_peak_processing_time){
-                asrc_peak_processing_time = t1 - t0;
-                #ifdef DEBUG_ASRC_TASK
-                // Use light-weight printintln instead of printf
-                printintln(asrc_peak_processing_time);
-                #endif
-                // xassert(asrc_peak_processing_time <= asrc_process_time_limit); // Optional assert on timing failure.
-                (void)asrc_peak_processing_time; // Remove compiler warning if above not used.
-                (void)asrc_process_time_limit; // Remove compiler warning
+        // Check for format changes - do before we process in case things have changed
+        if(asrc_detect_format_change(stream->input_frequency, stream->output_frequency, stream_io)){
+            // A new input rate alone switches over at this block, which is processed at the new rate. Otherwise re-initialise.
+            if(!(ASRC_TASK_FAST_RECONFIGURE &&
+                 stream_io->output_frequency == stream->output_frequency &&
+                 stream_io->input_channel_count == stream_io->asrc_channel_count &&
+                 asrc_check_valid_config(stream))){
+                stream_io->ready_flag_configured = 0;
+                stream->configured = false;
+                continue;
             }
-        } // while !asrc_detect_format_change()
+#ifdef DEBUG_ASRC_TASK
+            int32_t reconfigure_start = get_reference_time();
+#endif
+            asrc_stream_configure(stream, true);
+#ifdef DEBUG_ASRC_TASK
+            dprintf("Fast reconfigure ticks: %ld of %ld\n", get_reference_time() - reconfigure_start, stream->asrc_process_time_limit);
+#endif
+        }
+
+        int32_t t0 = get_reference_time();
+#if ASRC_TASK_PERSISTENT_WORKERS
+        int num_output_samples = persistent_par_asrc(&workers, stream->num_jobs, stream->schedule, stream->fs_ratio, stream_io, input_write_idx, stream->sASRCCtrl);
+#else
+        int num_output_samples = par_asrc(stream->num_jobs, stream->schedule, stream->fs_ratio, stream_io, input_write_idx, stream->sASRCCtrl);
+#endif
+#if ASRC_TASK_FIFO_FRACT_PHASE
+        uint32_t ts_fract;
+        int ts = asrc_timestamp_interpolation_fract(stream_io->input_timestamp[input_write_idx], stream->sASRCCtrl[0], stream->interpolation_ticks, &ts_fract);
+#else
+        int ts = asrc_timestamp_interpolation(stream_io->input_timestamp[input_write_idx], stream->sASRCCtrl[0], stream->interpolation_ticks);
+#endif
+        // Only push to FIFO if we have samples (FIFO has a bug) otherwise hold last error value
+        if(num_output_samples){
+#if ASRC_TASK_FIFO_FRACT_PHASE
+            stream->error = asynchronous_fifo_producer_put_fract(stream->fifo, &stream_io->output_samples[0], num_output_samples, ts, ts_fract);
+#else
+            stream->error = asynchronous_fifo_producer_put(stream->fifo, &stream_io->output_samples[0], num_output_samples, ts);
+#endif
+        }
+
+        stream->fs_ratio = (((int64_t)stream->ideal_fs_ratio) << 32) + (stream->error * (int64_t) stream->ideal_fs_ratio);
+
+        // Watermark for ASRC peak execution time
+        int32_t t1 = get_reference_time();
+        if(t1 - t0 > stream->asrc_peak_processing_time){
+            stream->asrc_peak_processing_time = t1 - t0;
+            #ifdef DEBUG_ASRC_TASK
+            // Use light-weight printintln instead of printf
+            printintln(stream->asrc_peak_processing_time);
+            #endif
+            // xassert(stream->asrc_peak_processing_time <= stream->asrc_process_time_limit); // Optional assert on timing failure.
+        }
     } // while 1
 }
 
 
-// Wrapper to setup ISR->task signalling chanend and use ISR friendly call to function
+// Wrapper to run a single stream
 void asrc_task(chanend_t c_asrc_input, asrc_in_out_t *asrc_io, asynchronous_fifo_t *fifo, unsigned fifo_length){
-    // Check callback is init'd. If not, use default implementation.
-    if (asrc_io->asrc_task_produce_cb == NULL){
-        asrc_io->asrc_task_produce_cb = receive_asrc_input_samples_cb_default;
+    asrc_task_multi(&c_asrc_input, &asrc_io, &fifo, &fifo_length, 1);
+}
+
+
+// Wrapper to check and setup the streams and use ISR friendly call to function
+void asrc_task_multi(chanend_t c_asrc_input[], asrc_in_out_t *asrc_io[], asynchronous_fifo_t *fifo[], unsigned fifo_length[], unsigned num_streams){
+    xassert(num_streams > 0 && num_streams <= MAX_ASRC_STREAMS); // Increase MAX_ASRC_STREAMS
+    for(int i = 0; i < num_streams; i++){
+        // Check callback is init'd. If not, use default implementation.
+        if (asrc_io[i]->asrc_task_produce_cb == NULL){
+            asrc_io[i]->asrc_task_produce_cb = receive_asrc_input_samples_cb_default;
+        }
+        // Resolve the block size. The buffers and arenas are sized for SRC_N_IN_SAMPLES so it cannot be larger.
+        if (asrc_io[i]->input_block_size == 0){
+            asrc_io[i]->input_block_size = SRC_N_IN_SAMPLES;
+        }
+        xassert((asrc_io[i]->input_block_size & 0x3) == 0 && asrc_io[i]->input_block_size <= SRC_N_IN_SAMPLES); // Invalid block size
+        // This is a workaround where only 4 params can be sent to INTERRUPT_PERMITTED(). So set it struct and extract in asrc_processor_() init
+        // http://bugzilla/show_bug.cgi?id=18745
+        fifo[i]->max_fifo_depth = fifo_length[i];
     }
-    // We use a single chanend to send the buffer IDX from the ISR of this task back to asrc task and sync
-    chanend_t c_buff_idx = chanend_alloc();
-    chanend_set_dest(c_buff_idx, c_buff_idx); // Loopback chanend to itself - we use this as a shallow event driven FIFO
-    // This is a workaround where only 4 params can be sent to INTERRUPT_PERMITTED(). So set it struct and extract in asrc_processor_() init
-    // http://bugzilla/show_bug.cgi?id=18745
-    fifo->max_fifo_depth = fifo_length;
     // Run the ASRC task with stack set aside for an ISR
-    INTERRUPT_PERMITTED(asrc_processor)(c_asrc_input, asrc_io, c_buff_idx, fifo);
+    INTERRUPT_PERMITTED(asrc_processor)(c_asrc_input, asrc_io, fifo, num_streams);
 }
 
 // Register a custom rx function for ASRC task
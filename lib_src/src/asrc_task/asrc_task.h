@@ -39,6 +39,59 @@
 
 #endif
 
+// Optional settings, see the documentation below
+#ifndef     ASRC_TASK_PID_GAIN_BOOST
+#define     ASRC_TASK_PID_GAIN_BOOST            0
+#endif
+
+#ifndef     ASRC_TASK_PID_SETTLE_TICKS
+#define     ASRC_TASK_PID_SETTLE_TICKS          32
+#endif
+
+#ifndef     ASRC_TASK_PID_SETTLE_MS
+#define     ASRC_TASK_PID_SETTLE_MS             100
+#endif
+
+#ifndef     ASRC_TASK_FIFO_FRACT_PHASE
+#define     ASRC_TASK_FIFO_FRACT_PHASE          0
+#endif
+
+#ifndef     ASRC_TASK_FIFO_ADAPTIVE_MARGIN
+#define     ASRC_TASK_FIFO_ADAPTIVE_MARGIN      0
+#endif
+
+#ifndef     ASRC_TASK_FIFO_ADAPTIVE_WINDOW_MS
+#define     ASRC_TASK_FIFO_ADAPTIVE_WINDOW_MS   1000
+#endif
+
+#ifndef     ASRC_TASK_PERSISTENT_WORKERS
+#define     ASRC_TASK_PERSISTENT_WORKERS        0
+#endif
+
+#if ASRC_TASK_PERSISTENT_WORKERS && defined(MAX_ASRC_THREADS) && (MAX_ASRC_THREADS < 2)
+#error      ASRC_TASK_PERSISTENT_WORKERS needs MAX_ASRC_THREADS of 2 or more
+#endif
+
+#ifndef     ASRC_TASK_WORKER_STACK_WORDS
+#define     ASRC_TASK_WORKER_STACK_WORDS        512
+#endif
+
+#ifndef     ASRC_TASK_THREAD_MHZ
+#define     ASRC_TASK_THREAD_MHZ                0
+#endif
+
+#ifndef     ASRC_TASK_FAST_RECONFIGURE
+#define     ASRC_TASK_FAST_RECONFIGURE          0
+#endif
+
+#ifndef     MAX_ASRC_STREAMS
+#define     MAX_ASRC_STREAMS                    1
+#endif
+
+#if MAX_ASRC_STREAMS > 4
+#error      MAX_ASRC_STREAMS must be 4 or less, one block from each stream may be waiting in the ASRC task at once
+#endif
+
 /** @brief Decorator for user's ASRC producer receive callback. Must be used to allow stack usage calculation. */
 #define  ASRC_TASK_ISR_CALLBACK_ATTR            __attribute__((fptrgroup("asrc_callback_isr_fptr_grp")))
 
@@ -52,6 +105,10 @@
 
 #define     SRC_MAX_NUM_SAMPS_OUT               (SRC_N_OUT_IN_RATIO_MAX * SRC_N_IN_SAMPLES)
 
+#if SRC_MAX_NUM_SAMPS_OUT > ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH
+#error      Please set ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH to at least SRC_N_IN_SAMPLES * SRC_N_OUT_IN_RATIO_MAX for the whole application
+#endif
+
 // These must be defined for lib_src
 #define     ASRC_N_IN_SAMPLES                   (SRC_N_IN_SAMPLES)                  // Used by SRC_STACK_LENGTH_MULT in src_mrhf_asrc.h
 #define     ASRC_N_CHANNELS                     (SRC_MAX_SRC_CHANNELS_PER_INSTANCE) // Used by SRC_STACK_LENGTH_MULT in src_mrhf_asrc.h
@@ -84,6 +141,19 @@ typedef struct {
     unsigned input_channel_count;
     /**< The function pointer of the ASRC_TASK producer receive callback. Must be defined by user to receive samples from producer over channel. */
     void * UNSAFE asrc_task_produce_cb;
+    /**< Number of input samples per channel in each block passed to asrc_process(). Set before calling asrc_task(). 0 selects
+         SRC_N_IN_SAMPLES, otherwise a multiple of 4 no larger than SRC_N_IN_SAMPLES. Receive callbacks use it to count samples per block. */
+    unsigned input_block_size;
+    /**< Number of consumers of the output FIFO. Set before calling asrc_task(). 0 or 1 for a single consumer, otherwise the
+         FIFO is a broadcast FIFO sized with ASYNCHRONOUS_FIFO_BROADCAST_INT64_ELEMENTS() and each consumer pulls from its own
+         handle, asynchronous_fifo_broadcast_consumer(). Handles move if the channel count changes, so look them up on each
+         pull_samples() call. The ASRC rate follows consumer 0, so all consumers must be clocked from consumer 0's clock;
+         sinks on different clock domains each need their own asrc_task. */
+    unsigned fifo_consumer_count;
+    /**< Optional run time statistics of the output FIFO, one block per consumer. Set before calling asrc_task(), NULL
+         disables them. They are cleared on every format change and may be read with asynchronous_fifo_get_stats() from
+         any thread. */
+    asynchronous_fifo_stats_t * UNSAFE fifo_stats;
 
     /**< Output sample array */
     int32_t output_samples[SRC_MAX_NUM_SAMPS_OUT * MAX_ASRC_CHANNELS_TOTAL];
@@ -99,6 +169,8 @@ typedef struct {
     int ready_flag_to_receive;
     /**< Flag to indicate ASRC is configured and OK to pull from FIFO */
     int ready_flag_configured;
+    /**< Samples received into the current block by receive_asrc_input_samples_cb_default() */
+    unsigned input_sample_counter;
 
 }asrc_in_out_t;
 
@@ -111,7 +183,8 @@ typedef unsigned (*asrc_task_produce_isr_cb_t)(chanend_t c_asrc_input, asrc_in_o
 
 
 /**
- * Main ASRC processor task. Runs forever waiting on new samples from the producer. Spawns up to MAX_ASRC_THREADS during ASRC processing.
+ * Main ASRC processor task. Runs forever waiting on new samples from the producer. Spawns up to MAX_ASRC_THREADS during ASRC processing,
+ * or starts MAX_ASRC_THREADS - 1 persistent worker threads once if ASRC_TASK_PERSISTENT_WORKERS is set.
  *
  * \param c_asrc_input      The channel end used to connect the producer to the ASRC task.
  * \param asrc_io           A pointer to the structure used for holding ASRC IO and state.
@@ -121,6 +194,21 @@ typedef unsigned (*asrc_task_produce_isr_cb_t)(chanend_t c_asrc_input, asrc_in_o
  */
 void asrc_task(chanend c_asrc_input, asrc_in_out_t * UNSAFE asrc_io, asynchronous_fifo_t * UNSAFE fifo, unsigned fifo_length);
 
+/**
+ * Multi-stream ASRC processor task. As asrc_task() but converts num_streams independent input streams, each with its own
+ * producer, input rate, asrc_in_out_t and output FIFO. Blocks are processed in the order they arrive and every stream
+ * uses the same MAX_ASRC_THREADS, so the total processing of all the streams must fit in them.
+ * MAX_ASRC_CHANNELS_TOTAL applies to each stream.
+ *
+ * \param c_asrc_input      The channel ends used to connect each producer to the ASRC task.
+ * \param asrc_io           Pointers to the structure used for holding ASRC IO and state of each stream.
+ * \param fifo              Pointers to the output FIFO of each stream.
+ * \param fifo_length       The length (depth) of each output FIFO. This is multiplied by channel count internally.
+ * \param num_streams       The number of streams, 1 to MAX_ASRC_STREAMS.
+ *
+ */
+void asrc_task_multi(chanend c_asrc_input[], asrc_in_out_t * UNSAFE asrc_io[], asynchronous_fifo_t * UNSAFE fifo[], unsigned fifo_length[], unsigned num_streams);
+
 /**
  * Helper function called by consumer to provide ASRC output samples. Samples are populated in the *samples array and the user
  * must provide the current nominal output frequency and a timestamp of when the last samples were consumed from the 100 MHz ref clock
@@ -180,12 +268,34 @@ void send_asrc_input_samples_default(chanend c_asrc_input, unsigned input_freque
 #define MAX_ASRC_CHANNELS_TOTAL             1
 /** @brief Maximum number of threads to be spawned by ASRC task. Used for buffer sizing and FIFO sizing (statically defined).*/
 #define MAX_ASRC_THREADS                    1
-/** @brief Block size of input to the low level asrc_process function. Must be a power of 2 and minimum value is 4, maximum is 16. Used for buffer sizing and FIFO sizing (statically defined). */
+/** @brief Maximum block size of input to the low level asrc_process function. Must be a multiple of 4. Used for buffer sizing and FIFO sizing (statically defined). The block size actually used is set at run time by asrc_in_out_t.input_block_size. */
 #define SRC_N_IN_SAMPLES                    4
 /** @brief  Max ratio between samples out:in per processing step (44.1->192 is worst case). Used for buffer sizing and FIFO sizing (statically defined). */
 #define SRC_N_OUT_IN_RATIO_MAX              5
 /** @brief Enables or disables quantisation of output with dithering to 24b. */
 #define SRC_DITHER_SETTING                  0
+/** @brief Optional. log2 of the FIFO PID bandwidth boost after a format change or reset, 0 (the default) disables the schedule. 3 locks in about 0.5 s instead of about 5 s. */
+#define ASRC_TASK_PID_GAIN_BOOST            0
+/** @brief Optional. Average phase error, in 100 MHz ticks, within which the FIFO PID counts as settled. Defaults to 32. */
+#define ASRC_TASK_PID_SETTLE_TICKS          32
+/** @brief Optional. Time the FIFO PID phase error is averaged over before each step down of the boost. Defaults to 100 ms. */
+#define ASRC_TASK_PID_SETTLE_MS             100
+/** @brief Optional. Set to 1 to timestamp FIFO puts to a fraction of a tick and use the sub-tick, block averaged FIFO phase detector, which reduces the ratio dither once locked, most at high input rates. Defaults to 0. */
+#define ASRC_TASK_FIFO_FRACT_PHASE          0
+/** @brief Optional. Frames of headroom kept by the FIFO in adaptive depth mode, 0 (the default) keeps the FIFO half full. */
+#define ASRC_TASK_FIFO_ADAPTIVE_MARGIN      0
+/** @brief Optional. Time the FIFO fill level is observed for before each reduction of the target in adaptive depth mode. Defaults to 1000 ms. */
+#define ASRC_TASK_FIFO_ADAPTIVE_WINDOW_MS   1000
+/** @brief Optional. Set to 1 to run the ASRC on MAX_ASRC_THREADS - 1 long-lived worker threads, started once, instead of forking and joining them for every block. The workers hold their threads permanently, even those ASRC_TASK_THREAD_MHZ leaves without a job. Defaults to 0. */
+#define ASRC_TASK_PERSISTENT_WORKERS        0
+/** @brief Optional. Stack of each persistent worker thread in words; it is checked against the stack the worker needs when the workers start. Defaults to 512. */
+#define ASRC_TASK_WORKER_STACK_WORDS        512
+/** @brief Optional. Thread MHz each ASRC job may use. When set, asrc_task uses as few of MAX_ASRC_THREADS as the cost of the rate pair allows, with no more than MAX_ASRC_CHANNELS_TOTAL / MAX_ASRC_THREADS channels each, leaving the rest idle. Persistent workers keep their threads, so with ASRC_TASK_PERSISTENT_WORKERS only their MIPS are freed. Defaults to 0, use all MAX_ASRC_THREADS. */
+#define ASRC_TASK_THREAD_MHZ                0
+/** @brief Optional. Set to 1 so that an input rate change alone re-initialises only the ASRC, at a block boundary, while the FIFO keeps playing and its PID keeps the ratio measured before the change. The output is silent for up to the filter delay of the new rate pair. Defaults to 0, fully re-initialise the ASRC and output FIFO on every format change. */
+#define ASRC_TASK_FAST_RECONFIGURE          0
+/** @brief Optional. Maximum number of input streams of asrc_task_multi(), up to 4. Used for sizing the ASRC state (statically defined). Defaults to 1. */
+#define MAX_ASRC_STREAMS                    1
 #endif
 
 /**@}*/ // END: addtogroup src_asrc_task
@@ -0,0 +1,82 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Only compile if we are using asrc_task
+#if __asrc_task_config_h_exists__
+
+#include "asrc_task_schedule.h"
+#include "use_vpu.h"
+
+
+// Thread MHz of the first channel of an ASRC instance [Fsin][Fsout], including the adaptive coefficient generation
+// it shares with the others, and of each further channel. Worst case with blocks of 4 input samples, as timed on
+// xcore-200 (see the ASRC resource usage tables in the documentation).
+static const int asrc_first_channel_mhz_2D[6][6] = {
+    { 29,  30,  40,  42,  62,  66},
+    { 33,  32,  42,  43,  63,  66},
+    { 47,  50,  58,  61,  80,  85},
+    { 55,  51,  67,  64,  84,  87},
+    { 60,  66,  76,  81, 105, 106},
+    { 69,  66,  82,  82, 109, 115}
+};
+
+static const int asrc_next_channel_mhz_2D[6][6] = {
+    { 28,  28,  32,  30,  40,  40},
+    { 39,  31,  33,  36,  40,  45},
+    { 51,  49,  57,  55,  65,  60},
+    { 51,  56,  57,  62,  66,  71},
+    { 60,  66,  76,  79,  92,  91},
+    { 69,  66,  76,  82,  90, 100}
+};
+
+
+int asrc_job_cost_mhz(int num_channels, int inputFsCode, int outputFsCode){
+    int cost_mhz = asrc_first_channel_mhz_2D[inputFsCode][outputFsCode] +
+                   (num_channels - 1) * asrc_next_channel_mhz_2D[inputFsCode][outputFsCode];
+#if SRC_USE_VPU
+    cost_mhz = (cost_mhz + 1) / 2; // The VPU filters on xcore.ai roughly halve it
+#endif
+    return cost_mhz;
+}
+
+
+// Channels are spread evenly, the first jobs take any remainder so schedule[0] is always the largest.
+int calculate_job_share(int asrc_channel_count,
+                        int inputFsCode,
+                        int outputFsCode,
+                        int max_jobs,
+                        int max_channels_per_job,
+                        int thread_mhz,
+                        schedule_info_t *schedule){
+    int num_jobs = asrc_channel_count < max_jobs ? asrc_channel_count : max_jobs;
+
+    if(asrc_channel_count <= 0){
+        return 0; // Nothing to do
+    }
+
+    if(thread_mhz > 0){
+        for(int jobs = 1; jobs < num_jobs; jobs++){
+            int channels_per_first_job = (asrc_channel_count + jobs - 1) / jobs; // Rounded up
+            // The ASRC state of each job only has room for max_channels_per_job channels
+            if(channels_per_first_job <= max_channels_per_job &&
+               asrc_job_cost_mhz(channels_per_first_job, inputFsCode, outputFsCode) <= thread_mhz){
+                num_jobs = jobs;
+                break;
+            }
+        }
+    }
+    // Use no more jobs than needed for the largest one, eg, 5 channels on 4 threads is 2 + 2 + 1
+    int channels_per_first_job = (asrc_channel_count + num_jobs - 1) / num_jobs;
+    num_jobs = (asrc_channel_count + channels_per_first_job - 1) / channels_per_first_job;
+
+    int channel_start_idx = 0;
+    for(int i = 0; i < num_jobs; i++){
+        schedule[i].num_channels = asrc_channel_count / num_jobs + (i < asrc_channel_count % num_jobs);
+        schedule[i].channel_start_idx = channel_start_idx;
+        channel_start_idx += schedule[i].num_channels;
+    }
+
+    return num_jobs;
+}
+
+#endif // __asrc_task_config_h_exists__
@@ -0,0 +1,26 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+#ifndef _ASRC_TASK_SCHEDULE_H_
+#define _ASRC_TASK_SCHEDULE_H_
+
+// Structure used for thread scheduling of parallel ASRC
+typedef struct schedule_info_t{
+    int num_channels;
+    int channel_start_idx;
+} schedule_info_t;
+
+// Estimated thread MHz of one ASRC instance processing num_channels channels from inputFsCode to outputFsCode
+int asrc_job_cost_mhz(int num_channels, int inputFsCode, int outputFsCode);
+
+// Generates a schedule of up to max_jobs jobs, of at most max_channels_per_job channels each, for asrc_channel_count
+// channels. With thread_mhz set it uses the fewest jobs whose estimated cost fits in thread_mhz, otherwise as many as
+// it can. Returns the number of jobs.
+int calculate_job_share(int asrc_channel_count,
+                        int inputFsCode,
+                        int outputFsCode,
+                        int max_jobs,
+                        int max_channels_per_job,
+                        int thread_mhz,
+                        schedule_info_t *schedule);
+
+#endif // _ASRC_TASK_SCHEDULE_H_
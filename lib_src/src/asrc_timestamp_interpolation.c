@@ -14,5 +14,16 @@ int asrc_timestamp_interpolation(int timestamp, asrc_ctrl_t *asrc_ctrl, int inte
     uint32_t fraction_away_from_final_ts = (((asrc_ctrl->iTimeInt - 128) << 8) |
                                             ((asrc_ctrl->uiTimeFract >> 24) & 0xff));
     int32_t left_over_ticks = (fraction_away_from_final_ts * interpolation_ticks) >> 16;
-    return timestamp + left_over_ticks;
+    // Modulo 2^32, the reference clock wraps
+    return (int32_t)((uint32_t)timestamp + (uint32_t)left_over_ticks);
+}
+
+int asrc_timestamp_interpolation_fract(int timestamp, asrc_ctrl_t *asrc_ctrl, int interpolation_ticks,
+                                       uint32_t *fract) {
+    // As above, but with 24 bits of uiTimeFract; the product is ticks in 32.32
+    uint32_t fraction_away_from_final_ts = (((asrc_ctrl->iTimeInt - 128) << 24) |
+                                            (asrc_ctrl->uiTimeFract >> 8));
+    uint64_t left_over_ticks = (uint64_t)fraction_away_from_final_ts * (uint32_t)interpolation_ticks;
+    *fract = (uint32_t)left_over_ticks;
+    return (int32_t)((uint32_t)timestamp + (uint32_t)(left_over_ticks >> 32));
 }
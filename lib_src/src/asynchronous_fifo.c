@@ -17,17 +17,234 @@
 
 // TODO: Make fifo offset from N/2 a very small component in PID,
 
+/*
+ * read_ptr and write_ptr helpers. With a power-of-two depth, index_mask is
+ * max_fifo_depth - 1 and the pointers are free-running counters that are
+ * masked when used as an index, so neither side needs a divide or a wrap
+ * test. Otherwise index_mask is all ones and the pointers wrap at
+ * max_fifo_depth with a compare.
+ */
+static inline uint32_t asynchronous_fifo_index(asynchronous_fifo_t *state, uint32_t ptr) {
+    return ptr & state->index_mask;
+}
+
+static inline uint32_t asynchronous_fifo_next(asynchronous_fifo_t *state, uint32_t ptr) {
+    ptr++;
+    if (ptr == (uint32_t)state->max_fifo_depth && state->index_mask == ~0u) {
+        ptr = 0;
+    }
+    return ptr;
+}
+
+static inline int asynchronous_fifo_len(asynchronous_fifo_t *state, uint32_t read_ptr, uint32_t write_ptr) {
+    int len = write_ptr - read_ptr;
+    if (len < 0) {                    // Only when wrapping at max_fifo_depth
+        len += state->max_fifo_depth;
+    }
+    return len;
+}
+
+/*
+ * 2^32/n rounded up for n = 2.., shared by all FIFOs. Built 32 entries at a
+ * time so the table covers ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH.
+ */
+#if ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH > 128
+#error ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH must be 128 or less
+#endif
+#define RECIPROCAL(n)       ((n) == 1 ? 0 : 0xffffffffu / (n) + 1)
+#define RECIPROCAL_4(n)     RECIPROCAL(n), RECIPROCAL(n + 1), RECIPROCAL(n + 2), RECIPROCAL(n + 3)
+#define RECIPROCAL_16(n)    RECIPROCAL_4(n), RECIPROCAL_4(n + 4), RECIPROCAL_4(n + 8), RECIPROCAL_4(n + 12)
+#define RECIPROCAL_32(n)    RECIPROCAL_16(n), RECIPROCAL_16(n + 16)
+
+static const uint32_t reciprocal_n[(ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH + 31) & ~31] = {
+    RECIPROCAL_32(1),
+#if ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH > 32
+    RECIPROCAL_32(33),
+#endif
+#if ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH > 64
+    RECIPROCAL_32(65),
+#endif
+#if ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH > 96
+    RECIPROCAL_32(97),
+#endif
+};
+
+/*
+ * Kp/n and x/n without a divide, for n up to ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH.
+ * Kp/n is exact, x/n uses a rounded up 0.32 reciprocal. Larger n only occur
+ * with very large blocks and fall back to a divide.
+ */
+static inline int32_t asynchronous_fifo_Kp_n(asynchronous_fifo_t *state, int n) {
+    if (n <= ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH) {
+        return state->Kp_n[n - 1];
+    }
+    return state->Kp / n;
+}
+
+static inline int32_t asynchronous_fifo_div_n(asynchronous_fifo_t *state, int32_t x, int n) {
+    if (n == 1) {
+        return x;
+    } else if (n <= ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH) {
+        return ((int64_t)x * reciprocal_n[n - 1]) >> 32;
+    }
+    return x / n;
+}
+
+/*
+ * Timestamps are free-running 32-bit tick counts that wrap every 2^32
+ * ticks, about 43 seconds at 100 MHz. They are only ever compared through
+ * differences taken modulo 2^32, which are correct across a wrap as long as
+ * the two timestamps are less than 2^31 ticks apart.
+ */
+static inline int32_t asynchronous_fifo_ticks_between(uint32_t later, uint32_t earlier) {
+    return (int32_t)(later - earlier);
+}
+
+static inline uint32_t *asynchronous_fifo_frame(asynchronous_fifo_t *state, uint32_t index) {
+    return (uint32_t *)state->samples + index * state->frame_words;
+}
+
+/*
+ * Records the consumer timestamp for the frame at index. With timestamp
+ * decimation only the first frame of every group of 1 << timestamp_shift
+ * frames has a timestamp.
+ */
+static inline void asynchronous_fifo_stamp(asynchronous_fifo_t *state, uint32_t index, uint32_t timestamp) {
+    if ((index & ((1 << state->timestamp_shift) - 1)) == 0) {
+        state->timestamps[index >> state->timestamp_shift] = timestamp;
+    }
+}
+
+/*
+ * Packs one frame of channel_count samples into the storage format. The
+ * packed formats keep the top 24 or 16 bits of each sample; 24-bit samples
+ * are packed four to three words, 16-bit samples two to a word.
+ */
+static void asynchronous_fifo_pack_frame(asynchronous_fifo_t *state, uint32_t *dst, const int32_t *src) {
+    int channel_count = state->channel_count;
+    int ch = 0;
+
+    if (state->format == ASYNCH_FIFO_FORMAT_PACKED24) {
+        for(; ch + 4 <= channel_count; ch += 4) {
+            uint32_t u0 = (uint32_t)src[ch + 0] >> 8;
+            uint32_t u1 = (uint32_t)src[ch + 1] >> 8;
+            uint32_t u2 = (uint32_t)src[ch + 2] >> 8;
+            uint32_t u3 = (uint32_t)src[ch + 3] >> 8;
+            *dst++ = u0 | (u1 << 24);
+            *dst++ = (u1 >> 8) | (u2 << 16);
+            *dst++ = (u2 >> 16) | (u3 << 8);
+        }
+        if (ch < channel_count) {
+            // Partial group: pack into a full one and keep the words in use
+            int32_t tail[4] = {0};
+            uint32_t packed[3];
+            int rem = channel_count - ch;
+            memcpy(tail, src + ch, rem * sizeof(int32_t));
+            packed[0] = ((uint32_t)tail[0] >> 8) | (((uint32_t)tail[1] >> 8) << 24);
+            packed[1] = ((uint32_t)tail[1] >> 16) | (((uint32_t)tail[2] >> 8) << 16);
+            packed[2] = ((uint32_t)tail[2] >> 24);
+            memcpy(dst, packed, ((rem * 3 + 3) >> 2) * sizeof(uint32_t));
+        }
+    } else if (state->format == ASYNCH_FIFO_FORMAT_INT16) {
+        for(; ch + 2 <= channel_count; ch += 2) {
+            *dst++ = ((uint32_t)src[ch] >> 16) | ((uint32_t)src[ch + 1] & 0xffff0000);
+        }
+        if (ch < channel_count) {
+            *dst = (uint32_t)src[ch] >> 16;
+        }
+    } else {
+        memcpy(dst, src, channel_count * sizeof(int32_t));
+    }
+}
+
+/*
+ * Unpacks one stored frame into channel_count samples, dst_stride apart.
+ */
+static void asynchronous_fifo_unpack_frame(asynchronous_fifo_t *state, int32_t *dst, int dst_stride, const uint32_t *src) {
+    int channel_count = state->channel_count;
+    int ch = 0;
+
+    if (state->format == ASYNCH_FIFO_FORMAT_PACKED24) {
+        for(; ch + 4 <= channel_count; ch += 4) {
+            uint32_t w0 = src[0], w1 = src[1], w2 = src[2];
+            dst[(ch + 0) * dst_stride] = w0 << 8;
+            dst[(ch + 1) * dst_stride] = ((w0 >> 24) | (w1 << 8)) << 8;
+            dst[(ch + 2) * dst_stride] = ((w1 >> 16) | (w2 << 16)) << 8;
+            dst[(ch + 3) * dst_stride] = w2 & 0xffffff00;
+            src += 3;
+        }
+        if (ch < channel_count) {
+            uint32_t packed[3] = {0};
+            int rem = channel_count - ch;
+            memcpy(packed, src, ((rem * 3 + 3) >> 2) * sizeof(uint32_t));
+            dst[ch * dst_stride] = packed[0] << 8;
+            if (rem > 1) {
+                dst[(ch + 1) * dst_stride] = ((packed[0] >> 24) | (packed[1] << 8)) << 8;
+            }
+            if (rem > 2) {
+                dst[(ch + 2) * dst_stride] = ((packed[1] >> 16) | (packed[2] << 16)) << 8;
+            }
+        }
+    } else if (state->format == ASYNCH_FIFO_FORMAT_INT16) {
+        for(; ch + 2 <= channel_count; ch += 2) {
+            uint32_t w = *src++;
+            dst[ch * dst_stride] = w << 16;
+            dst[(ch + 1) * dst_stride] = w & 0xffff0000;
+        }
+        if (ch < channel_count) {
+            dst[ch * dst_stride] = *src << 16;
+        }
+    } else {
+        for(; ch < channel_count; ch++) {
+            dst[ch * dst_stride] = src[ch];
+        }
+    }
+}
+
+/**
+ * Function that returns the ideal phase error for the target fill level.
+ * Consumer timestamps are read one lap of the FIFO behind the producer, so
+ * a fill level of target_depth frames leaves max_fifo_depth - target_depth
+ * samples between them; half full is the default ideal phase error.
+ */
+static inline int32_t asynchronous_fifo_target_ticks(asynchronous_fifo_t *state) {
+    return state->ticks_between_samples * (state->max_fifo_depth - state->target_depth);
+}
+
+static inline int32_t asynchronous_fifo_max_target(asynchronous_fifo_t *state) {
+    return state->max_fifo_depth - (state->max_fifo_depth/2 + 1);
+}
+
+#define K_SHIFT 16
+
 /**
  * Function that resets the producing side of the ASRC; called on initialisation, and
  * and called during reset by the producer after the consumer is known to have thrown
  * in the towel
  */
 static void asynchronous_fifo_init_producing_side(asynchronous_fifo_t *state) {
-    state->skip_ctr = state->max_fifo_depth / 2 + 2;
-    state->write_ptr = (state->read_ptr + state->max_fifo_depth/2) % state->max_fifo_depth;
+    // Skip measuring until the group at the write pointer was stamped by the
+    // consumer one lap earlier: half the FIFO plus a group of frames
+    state->skip_ctr = state->max_fifo_depth / 2 + (1 << state->timestamp_shift) + 1;
+    state->write_ptr = state->read_ptr + state->max_fifo_depth/2;
+    if (state->index_mask == ~0u && state->write_ptr >= (uint32_t)state->max_fifo_depth) {
+        state->write_ptr -= state->max_fifo_depth;
+    }
     state->last_phase_error = 0;
-    state->frequency_ratio = 0;   // Assume perfect match
+    state->last_proportional = 0;
+    state->frequency_ratio = (int64_t)state->ratio_seed << K_SHIFT;   // Perfect match unless seeded
     state->stop_producing = 0;
+    state->gain_boost = state->gain_boost_max;
+    state->settle_ctr = 0;
+    state->settle_sum = 0;
+    if (state->adapt_margin != 0) {
+        // The FIFO restarts half full, so the target does too
+        state->target_depth = asynchronous_fifo_max_target(state);
+        state->ideal_phase_error_ticks = asynchronous_fifo_target_ticks(state);
+        state->adapt_ctr = 0;
+        state->adapt_min_len = state->max_fifo_depth;
+        state->slew_ctr = 0;
+    }
 }
 
 /**
@@ -39,8 +256,6 @@ static void asynchronous_fifo_reset_consumer_flags(asynchronous_fifo_t *state) {
     state->reset = 0;        // This has to be the last one
 }
 
-#define K_SHIFT 16
-
 static int ticks_between_samples_1D[6] = {
     2268,2083,1134,1042, 567, 521
 };
@@ -63,12 +278,37 @@ static int Kp_2D[6][6] = {
     {   7036874,   7036874,  14073749,  14073749,  28147498,  28147498 }
 };
 
+/**
+ * Function that pre-scales Kp for every n in the table, so the PID does not
+ * divide on each put.
+ */
+static void asynchronous_fifo_init_Kp_n(asynchronous_fifo_t *state) {
+    for(int n = 1; n <= ASYNCHRONOUS_FIFO_PID_TABLE_LENGTH; n++) {
+        state->Kp_n[n - 1] = state->Kp / n;
+    }
+}
+
+/**
+ * Function that sets the ideal phase error for the target fill level after
+ * the sample period is set: half full, or the current target in adaptive
+ * depth mode so that the PID may be changed while the FIFO is running.
+ */
+static void asynchronous_fifo_init_ideal_phase(asynchronous_fifo_t *state, int max_fifo_depth) {
+    if (state->adapt_margin != 0) {
+        state->ideal_phase_error_ticks = asynchronous_fifo_target_ticks(state);
+    } else {
+        state->ideal_phase_error_ticks = state->ticks_between_samples * (max_fifo_depth/2 + 1);
+    }
+}
+
 void asynchronous_fifo_init_PID_fs_codes(asynchronous_fifo_t *state,
                                          int fs_input, int fs_output) {
     int max_fifo_depth = state->max_fifo_depth;
     state->Kp = Kp_2D[fs_input][fs_output];
     state->Ki = Ki_2D[fs_input][fs_output];
-    state->ideal_phase_error_ticks = ticks_between_samples_1D[fs_output] * (max_fifo_depth/2 + 1);
+    asynchronous_fifo_init_Kp_n(state);
+    state->ticks_between_samples = ticks_between_samples_1D[fs_output];
+    asynchronous_fifo_init_ideal_phase(state, max_fifo_depth);
 }
 
 void asynchronous_fifo_init_PID_raw(asynchronous_fifo_t *state,
@@ -76,30 +316,254 @@ void asynchronous_fifo_init_PID_raw(asynchronous_fifo_t *state,
     int max_fifo_depth = state->max_fifo_depth;
     state->Kp = Kp;
     state->Ki = Ki;
-    state->ideal_phase_error_ticks = ticks_between_samples * (max_fifo_depth/2 + 1);
+    asynchronous_fifo_init_Kp_n(state);
+    state->ticks_between_samples = ticks_between_samples;
+    asynchronous_fifo_init_ideal_phase(state, max_fifo_depth);
 }
 
-void asynchronous_fifo_init(asynchronous_fifo_t *state, int channel_count,
-                            int max_fifo_depth) {
+void asynchronous_fifo_init_ratio(asynchronous_fifo_t *state, int32_t ratio) {
+    state->ratio_seed = ratio;
+    state->frequency_ratio = (int64_t)ratio << K_SHIFT;
+    state->ratio = ratio;
+}
+
+void asynchronous_fifo_init_PID_schedule(asynchronous_fifo_t *state,
+                                         int gain_boost, int settle_ticks, int settle_puts) {
+    state->gain_boost_max = gain_boost;
+    state->settle_ticks = settle_ticks;
+    state->settle_puts = settle_puts;
+    state->gain_boost = gain_boost;
+    state->settle_ctr = 0;
+    state->settle_sum = 0;
+}
+
+void asynchronous_fifo_init_adaptive_depth(asynchronous_fifo_t *state,
+                                           int margin, int window_puts) {
+    int slew_frames = ASYNCHRONOUS_FIFO_DEPTH_SLEW_TICKS / state->ticks_between_samples;
+    state->adapt_margin = margin;
+    state->adapt_window = window_puts;
+    state->slew_frames = slew_frames > 0 ? slew_frames : 1;
+    if (margin != 0) {
+        asynchronous_fifo_init_producing_side(state);
+    } else {
+        state->ideal_phase_error_ticks = state->ticks_between_samples * (state->max_fifo_depth/2 + 1);
+    }
+}
+
+void asynchronous_fifo_init_timestamp_scale(asynchronous_fifo_t *state, uint64_t scale) {
+    // Every consumer of a broadcast FIFO converts its own timestamps
+    for(asynchronous_fifo_t *consumer = state; consumer != NULL; consumer = consumer->next_consumer) {
+        consumer->timestamp_scale = scale;
+    }
+}
+
+int32_t asynchronous_fifo_scale_timestamp(asynchronous_fifo_t *state, uint64_t timestamp,
+                                          uint32_t *fract) {
+    // Ticks in 32.32; only the low 64 bits of the product are needed, so
+    // the result wraps as the reference clock would
+    uint64_t ticks = timestamp * state->timestamp_scale;
+
+    if (fract != NULL) {
+        *fract = (uint32_t)ticks;
+    } else {
+        ticks += 1u << 31;              // Round to the nearest tick
+    }
+    return (int32_t)(uint32_t)(ticks >> 32);
+}
+
+/**
+ * Function that initialises one consumer's view of a FIFO, whose frames are
+ * stored at samples; called for a plain FIFO and for each consumer of a
+ * broadcast FIFO.
+ */
+static void asynchronous_fifo_init_consumer(asynchronous_fifo_t *state, int channel_count,
+                                            int max_fifo_depth,
+                                            asynchronous_fifo_format_t format,
+                                            int timestamp_decimation,
+                                            int32_t *samples,
+                                            uint32_t *timestamps) {
+    int timestamp_shift = 0;
+    while ((2 << timestamp_shift) <= timestamp_decimation) {
+        timestamp_shift++;
+    }
     state->max_fifo_depth = max_fifo_depth;
-    state->timestamps = (uint32_t *)state->buffer + max_fifo_depth * channel_count;
+    state->format = format;
+    state->frame_words = ASYNCHRONOUS_FIFO_FRAME_WORDS(channel_count, format);
+    state->timestamp_shift = timestamp_shift;
+    state->samples = samples;
+    state->timestamps = timestamps;
+    state->consumer_count = 1;
+    state->next_consumer = NULL;
+    state->gain_boost_max = 0;
+    state->adapt_margin = 0;
+    state->ratio_seed = 0;
+    state->stats = NULL;
+    state->timestamp_scale = 1ull << 32;
     state->channel_count = channel_count;
     state->copy_mask     = (1 << (4*channel_count)) - 1;
+    if ((max_fifo_depth & (max_fifo_depth - 1)) == 0) {
+        state->index_mask = max_fifo_depth - 1;
+    } else {
+        state->index_mask = ~0u;
+    }
 
     // First initialise shared variables, or those that shouldn't reset on a RESET.
     state->read_ptr = 0;
-    // Now clear the buffer.
-    memset(state->buffer, 0, channel_count * max_fifo_depth * sizeof(int));
+    state->last_timestamp = 0;
+    state->ratio = 0;
+    state->last_put_timestamp = 0;
+    state->last_put_fract = 0;
     // Finally initialise those parts that are reset on a RESET
     asynchronous_fifo_init_producing_side(state);    // uses read_ptr
     asynchronous_fifo_reset_consumer_flags(state);
 }
 
+/**
+ * Function that checks a timestamp decimation: a power of two, and at most
+ * a quarter of the FIFO so that the adaptive target, which stays at or
+ * above it, always leaves the producer a group stamped one lap earlier.
+ */
+static int asynchronous_fifo_decimation_ok(int max_fifo_depth, int timestamp_decimation) {
+    if (timestamp_decimation == 1) {
+        return 1;
+    }
+    return timestamp_decimation > 1 && (timestamp_decimation & (timestamp_decimation - 1)) == 0 &&
+           timestamp_decimation <= max_fifo_depth / 4;
+}
+
+int asynchronous_fifo_init_format(asynchronous_fifo_t *state, int channel_count,
+                                  int max_fifo_depth,
+                                  asynchronous_fifo_format_t format,
+                                  int timestamp_decimation) {
+    int frame_words = ASYNCHRONOUS_FIFO_FRAME_WORDS(channel_count, format);
+    if (!asynchronous_fifo_decimation_ok(max_fifo_depth, timestamp_decimation)) {
+        return -1;
+    }
+    // Clear the buffer, the timestamps follow it
+    memset(state->buffer, 0, frame_words * max_fifo_depth * sizeof(int));
+    asynchronous_fifo_init_consumer(state, channel_count, max_fifo_depth, format, timestamp_decimation,
+                                    state->buffer, (uint32_t *)state->buffer + max_fifo_depth * frame_words);
+    return 0;
+}
+
+int asynchronous_fifo_broadcast_init(asynchronous_fifo_t *state, int consumer_count,
+                                     int channel_count, int max_fifo_depth,
+                                     asynchronous_fifo_format_t format,
+                                     int timestamp_decimation) {
+    if (asynchronous_fifo_init_format(state, channel_count, max_fifo_depth, format, timestamp_decimation) != 0) {
+        return -1;
+    }
+    // The first consumer holds the frames, the others follow with just their timestamps
+    int64_t *next = (int64_t *)state + ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(max_fifo_depth, channel_count,
+                                                                               format, timestamp_decimation);
+    asynchronous_fifo_t *last = state;
+
+    for(int i = 1; i < consumer_count; i++) {
+        asynchronous_fifo_t *consumer = (asynchronous_fifo_t *)next;
+        asynchronous_fifo_init_consumer(consumer, channel_count, max_fifo_depth, format, timestamp_decimation,
+                                        state->samples, (uint32_t *)consumer->buffer);
+        last->next_consumer = consumer;
+        last = consumer;
+        next += ASYNCHRONOUS_FIFO_CONSUMER_INT64_ELEMENTS(max_fifo_depth, timestamp_decimation);
+    }
+    for(asynchronous_fifo_t *consumer = state; consumer != NULL; consumer = consumer->next_consumer) {
+        consumer->consumer_count = consumer_count;
+    }
+    state->shared_write_ptr = state->write_ptr;
+    return 0;
+}
+
+asynchronous_fifo_t *asynchronous_fifo_broadcast_consumer(asynchronous_fifo_t *state, int consumer) {
+    while (consumer-- > 0 && state != NULL) {
+        state = state->next_consumer;
+    }
+    return state;
+}
+
+void asynchronous_fifo_init(asynchronous_fifo_t *state, int channel_count,
+                            int max_fifo_depth) {
+    asynchronous_fifo_init_format(state, channel_count, max_fifo_depth,
+                                  ASYNCH_FIFO_FORMAT_INT32, 1);
+}
+
 void asynchronous_fifo_exit(asynchronous_fifo_t *state) {
 }
 
 int async_resets = 0;
 
+void asynchronous_fifo_enable_stats(asynchronous_fifo_t *state,
+                                    asynchronous_fifo_stats_t *stats) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(*stats));
+        stats->min_fill = state->max_fifo_depth;
+    }
+    state->stats = stats;
+}
+
+void asynchronous_fifo_get_stats(asynchronous_fifo_t *state,
+                                 asynchronous_fifo_stats_t *copy) {
+    asynchronous_fifo_stats_t *stats = state->stats;
+    uint32_t sequence;
+    if (stats == NULL) {
+        memset(copy, 0, sizeof(*copy));
+        return;
+    }
+    // Retry if the producer was part way through an update
+    do {
+        sequence = stats->sequence;
+        asm volatile("" ::: "memory");
+        memcpy(copy, stats, sizeof(*copy));
+        asm volatile("" ::: "memory");
+    } while ((sequence & 1) || sequence != stats->sequence);
+    copy->mean_fill = copy->fill_count ? (int32_t)((copy->fill_sum << 8) / copy->fill_count) : 0;
+}
+
+#define ASYNCH_FIFO_STATS_NONE      0
+#define ASYNCH_FIFO_STATS_RESET     1
+#define ASYNCH_FIFO_STATS_OVERFLOW  2
+#define ASYNCH_FIFO_STATS_PUT       3
+
+/**
+ * Function that updates the statistics after a put; len is the fill level
+ * before the n frames were written. The sequence number is odd during the
+ * update so that asynchronous_fifo_get_stats() can take a consistent copy.
+ */
+static void asynchronous_fifo_update_stats(asynchronous_fifo_t *state, int event,
+                                           int n, int len, int fract_bits) {
+    asynchronous_fifo_stats_t *stats = state->stats;
+    stats->sequence++;
+    asm volatile("" ::: "memory");
+    if (event == ASYNCH_FIFO_STATS_RESET) {
+        stats->resets++;
+        stats->locked_frames = 0;
+    } else if (event == ASYNCH_FIFO_STATS_OVERFLOW) {
+        stats->overflows++;
+        stats->locked_frames = 0;
+    } else {
+        if (len < stats->min_fill) {
+            stats->min_fill = len;
+        }
+        if (len > stats->max_fill) {
+            stats->max_fill = len;
+        }
+        stats->fill_sum += len;
+        stats->fill_count++;
+        if (state->skip_ctr == 0 && state->gain_boost == 0) {
+            int32_t phase_error = state->last_phase_error >> fract_bits;
+            if (phase_error < 0) {
+                phase_error = -phase_error;
+            }
+            if (stats->locked_frames == 0 || phase_error > stats->max_phase_error) {
+                stats->max_phase_error = phase_error;
+            }
+            stats->locked_frames += n;
+        }
+    }
+    stats->ratio = state->ratio;
+    asm volatile("" ::: "memory");
+    stats->sequence++;
+}
+
 void asynchronous_fifo_reset_producer(asynchronous_fifo_t *state) {
     state->stop_producing = 1;
 }
@@ -108,69 +572,357 @@ void asynchronous_fifo_reset_consumer(asynchronous_fifo_t *state) {
     state->reset = 1;
 }
 
-int32_t asynchronous_fifo_producer_put(asynchronous_fifo_t *state, int32_t *samples,
-                                  int n,
-                                  int32_t timestamp) {
-    int read_ptr = state->read_ptr;
-    int write_ptr = state->write_ptr;
-    int max_fifo_depth = state->max_fifo_depth;
+/**
+ * Function that stores n frames from samples at write_ptr onwards, and
+ * returns the write pointer after them.
+ */
+static uint32_t asynchronous_fifo_write_frames(asynchronous_fifo_t *state, int32_t *samples,
+                                               int n, uint32_t write_ptr) {
     int channel_count = state->channel_count;
     int copy_mask = state->copy_mask;
-    int len = (write_ptr - read_ptr + max_fifo_depth) % max_fifo_depth;
-    if (state->reset) {
-        async_resets++;
-        asynchronous_fifo_init_producing_side(state);    // uses read_ptr
-        asynchronous_fifo_reset_consumer_flags(state);   // Last step - clears reset
-    } else if (len >= max_fifo_depth - 2 - n) {
-        state->stop_producing = 1;
-    } else if (!state->stop_producing && n) {
-        for(int j = 0; j < n; j++) {
-
+    for(int j = 0; j < n; j++) {
+        uint32_t *frame = asynchronous_fifo_frame(state, asynchronous_fifo_index(state, write_ptr));
+        if (state->format != ASYNCH_FIFO_FORMAT_INT32) {
+            asynchronous_fifo_pack_frame(state, frame, samples);
+        } else {
 #ifdef __XS2A__
-            memcpy(state->buffer + write_ptr * channel_count, samples, channel_count * sizeof(int));
+            memcpy(frame, samples, channel_count * sizeof(int));
             (void)copy_mask; // Remove unused var warning
 #else
             register int32_t *ptr asm("r11") = samples;
             asm("vldr %0[0]" :: "r" (ptr));
-            asm("vstrpv %0[0], %1" :: "r" (state->buffer + write_ptr * channel_count), "r" (copy_mask));
+            asm("vstrpv %0[0], %1" :: "r" (frame), "r" (copy_mask));
 #endif
-            samples += channel_count;
-            write_ptr = (write_ptr + 1);
-            if (write_ptr >= max_fifo_depth) {
-                write_ptr = 0;
-            }
         }
+        samples += channel_count;
+        write_ptr = asynchronous_fifo_next(state, write_ptr);
+    }
+    return write_ptr;
+}
+
+/*
+ * Consumer timestamp of the frame at index, extrapolated from the start of
+ * its group when timestamps are decimated.
+ */
+static inline uint32_t asynchronous_fifo_consumer_time(asynchronous_fifo_t *state, uint32_t index) {
+    uint32_t group_offset = index & ((1 << state->timestamp_shift) - 1);
+    return state->timestamps[index >> state->timestamp_shift] + group_offset * (uint32_t)state->ticks_between_samples;
+}
+
+/**
+ * Function that measures the phase error in ticks after frames have been
+ * written up to state->write_ptr, the last of which was input at timestamp.
+ */
+static int32_t asynchronous_fifo_phase_error(asynchronous_fifo_t *state, int32_t timestamp) {
+    /* Difference between timestamp recorded by consumer and current timestamp */
+    int32_t phase_error = asynchronous_fifo_ticks_between(
+        asynchronous_fifo_consumer_time(state, asynchronous_fifo_index(state, state->write_ptr)), timestamp);
+
+    /* Ideal phase error is the middle of the fifo measured in ticks */
+    return phase_error + state->ideal_phase_error_ticks;
+}
+
+/**
+ * Function that measures the phase error in 1/2^ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS
+ * ticks, averaged over the n frames just written. Frame n-1-k is compared
+ * with the consumer timestamp of the slot after it, as in
+ * asynchronous_fifo_phase_error(). It was input k/n of the way back from
+ * timestamp + timestamp_fract to the timestamp of the previous put; using
+ * the measured rather than the ideal sample period keeps the average
+ * independent of n when the rates are not nominal. Only the producer does
+ * more work.
+ */
+static int32_t asynchronous_fifo_phase_error_fract(asynchronous_fifo_t *state, int n,
+                                                   int32_t timestamp, uint32_t timestamp_fract) {
+    const int fb = ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS;
+    uint32_t index = asynchronous_fifo_index(state, state->write_ptr);
+    uint32_t target = (uint32_t)timestamp - state->ideal_phase_error_ticks;
+    int32_t sum = 0;
+
+    for(int k = 0; k < n; k++) {
+        sum += asynchronous_fifo_ticks_between(asynchronous_fifo_consumer_time(state, index), target);
+        index = (index == 0 ? state->max_fifo_depth : index) - 1;
+    }
+    // Ticks covered by the n frames, frame k is k * span / n before the last
+    int32_t span = asynchronous_fifo_ticks_between(timestamp, state->last_put_timestamp) * (1 << fb) +
+                   (int32_t)(timestamp_fract >> (32 - fb)) -
+                   (int32_t)(state->last_put_fract >> (32 - fb));
+    state->last_put_timestamp = timestamp;
+    state->last_put_fract = timestamp_fract;
 
-        /* Difference between timestamp recorded by consumer and current timestamp */
-        state->write_ptr = write_ptr;
-        int32_t phase_error = state->timestamps[write_ptr] - timestamp;
+    int32_t total = (sum << fb) + (int32_t)(((int64_t)span * (n - 1)) >> 1);
+    return asynchronous_fifo_div_n(state, total, n) - (int32_t)(timestamp_fract >> (32 - fb));
+}
 
-        /* Ideal phase error is the middle of the fifo measured in ticks */
-        phase_error += state->ideal_phase_error_ticks;
+/**
+ * Function that runs the PID on a phase error measured in 1/2^fract_bits
+ * ticks, after n frames have been written.
+ */
+static void asynchronous_fifo_update_PID(asynchronous_fifo_t *state, int n, int32_t phase_error, int fract_bits) {
+    // A boost of g scales Kp by 2^g and Ki by 2^2g: 2^g times the loop
+    // bandwidth at the same damping
+    int gain_boost = state->gain_boost;
+    int64_t Kp = (int64_t) asynchronous_fifo_Kp_n(state, n) << gain_boost;
+    int64_t Ki = (int64_t) state->Ki << (2 * gain_boost);
+    int64_t proportional = phase_error * Kp;
 
-        /* Don't try and use timestamps that haven't been recorded yet! */
-        if (state->skip_ctr != 0) {
-            state->skip_ctr--;
+    /* Don't try and use timestamps that haven't been recorded yet! */
+    if (state->skip_ctr != 0) {
+        state->skip_ctr--;
+    } else {
+        // Now that we have a phase error, calculate the proportional error
+        // and use that and the integral error to correct the ASRC factor.
+        // With a gain schedule the proportional term is differenced after
+        // scaling, so it still sums to Kp/n times the error when n or the
+        // boost varies from put to put. Without one the error is differenced
+        // first, as the loop always has been.
+        int64_t diff_proportional;
+        if (state->gain_boost_max != 0) {
+            diff_proportional = proportional - state->last_proportional;
         } else {
-            // Now that we have a phase error, calculate the proportional error
-            // and use that and the integral error to correct the ASRC factor
             int32_t diff_error = phase_error - state->last_phase_error;
+            diff_proportional = diff_error * Kp;
+        }
+        state->frequency_ratio +=
+            (diff_proportional +
+             (phase_error * Ki)) >> fract_bits;
 
-            state->frequency_ratio +=
-                (diff_error  * (int64_t) (state->Kp / n)) +  // TODO: make this lookup table
-                (phase_error * (int64_t) state->Ki);
+        // Step the boost down once the phase error has settled, on average
+        // over settle_puts puts so that clock jitter does not hold it up
+        if (gain_boost != 0) {
+            state->settle_sum += phase_error >> fract_bits;
+            if (++state->settle_ctr >= state->settle_puts) {
+                int64_t limit = (int64_t) state->settle_ticks * state->settle_puts;
+                if (state->settle_sum < limit && state->settle_sum > -limit) {
+                    state->gain_boost = gain_boost - 1;
+                }
+                state->settle_ctr = 0;
+                state->settle_sum = 0;
+            }
+        }
 #if defined(ASYNC_FIFO_XSCOPE_INSTRUMENTATION)
-                xscope_int(1, phase_error);
-                xscope_int(2, diff_error);
+            xscope_int(1, phase_error);
+            xscope_int(2, phase_error - state->last_phase_error);
 #endif
+    }
+    state->last_phase_error = phase_error;
+    state->last_proportional = proportional;
+}
+
+/**
+ * Function that adapts the target fill level in adaptive depth mode, given
+ * the number of frames len in the FIFO before the n frames of this put were
+ * written. That is the low point of the fill level, and the consumer resets
+ * on reaching two frames. If the headroom above that drops below the margin
+ * the target is raised by a frame straight away. If the lowest headroom over
+ * a whole window of puts leaves two frames to spare, and the PID has
+ * finished its boost, the target is lowered by a frame; the phase target
+ * then ramps one tick per slew_frames frames, so the rate change is small.
+ * The target stays at or above the timestamp decimation, otherwise the
+ * group the producer measures against could be stamped in the current lap
+ * rather than the previous one.
+ */
+static void asynchronous_fifo_adapt_depth(asynchronous_fifo_t *state, int n, int len) {
+    int headroom = len - 2;
+    int32_t target_ticks;
+
+    if (headroom < state->adapt_margin) {
+        if (state->target_depth < asynchronous_fifo_max_target(state)) {
+            state->target_depth++;
+        }
+        state->ideal_phase_error_ticks = asynchronous_fifo_target_ticks(state);
+        state->adapt_ctr = 0;
+        state->adapt_min_len = state->max_fifo_depth;
+        return;
+    }
+    if (len < state->adapt_min_len) {
+        state->adapt_min_len = len;
+    }
+
+    target_ticks = asynchronous_fifo_target_ticks(state);
+    if (state->ideal_phase_error_ticks < target_ticks) {
+        state->slew_ctr += n;
+        while (state->slew_ctr >= state->slew_frames && state->ideal_phase_error_ticks < target_ticks) {
+            state->ideal_phase_error_ticks++;
+            state->slew_ctr -= state->slew_frames;
+        }
+    } else {
+        state->ideal_phase_error_ticks = target_ticks;
+        state->slew_ctr = 0;
+    }
+
+    if (++state->adapt_ctr >= state->adapt_window) {
+        if (state->ideal_phase_error_ticks == target_ticks && state->gain_boost == 0 &&
+            state->adapt_min_len - 2 >= state->adapt_margin + 2 &&
+            state->adapt_min_len > (1 << state->timestamp_shift) &&
+            state->target_depth > (1 << state->timestamp_shift)) {
+            state->target_depth--;
+        }
+        state->adapt_ctr = 0;
+        state->adapt_min_len = state->max_fifo_depth;
+    }
+}
+
+/**
+ * Function that writes the frames and, unless the FIFO is stopped, runs the
+ * PID on one consumer. fract_bits selects the phase detector: 0 for whole
+ * ticks at the last frame, ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS for the sub-tick
+ * block average.
+ */
+static void asynchronous_fifo_measure(asynchronous_fifo_t *state, int n,
+                                      int32_t timestamp, uint32_t timestamp_fract, int fract_bits) {
+    int32_t phase_error;
+    if (fract_bits) {
+        phase_error = asynchronous_fifo_phase_error_fract(state, n, timestamp, timestamp_fract);
+    } else {
+        phase_error = asynchronous_fifo_phase_error(state, timestamp);
+    }
+    asynchronous_fifo_update_PID(state, n, phase_error, fract_bits);
+}
+
+/**
+ * Function that measures the phase error of a broadcast consumer other than
+ * consumer 0, without running its PID: the frames are produced at consumer
+ * 0's rate, so a ratio for this consumer would not be acted on. It counts
+ * as locked once its first timestamps are recorded.
+ */
+static void asynchronous_fifo_measure_phase(asynchronous_fifo_t *state, int n,
+                                            int32_t timestamp, uint32_t timestamp_fract, int fract_bits) {
+    if (fract_bits) {
+        state->last_phase_error = asynchronous_fifo_phase_error_fract(state, n, timestamp, timestamp_fract);
+    } else {
+        state->last_phase_error = asynchronous_fifo_phase_error(state, timestamp);
+    }
+    if (state->skip_ctr != 0) {
+        state->skip_ctr--;
+    }
+    state->gain_boost = 0;
+}
+
+/**
+ * Producer side of a broadcast FIFO. The frames are stored once, at the
+ * shared write pointer, and each consumer is then updated as a plain FIFO
+ * would be, except that only consumer 0 runs its PID and adapts its depth;
+ * the others only measure their phase error. A consumer that would overflow is stopped before the frames are
+ * written and the others carry on; its unread frames are overwritten from
+ * then on, so it resets on its next get rather than draining them. A
+ * consumer that asked for a reset is moved to half a FIFO behind the shared
+ * write pointer; it does not touch read_ptr until reset is cleared.
+ */
+static int32_t asynchronous_fifo_broadcast_put(asynchronous_fifo_t *state, int32_t *samples, int n,
+                                               int32_t timestamp, uint32_t timestamp_fract, int fract_bits) {
+    int max_fifo_depth = state->max_fifo_depth;
+
+    for(asynchronous_fifo_t *consumer = state; consumer != NULL; consumer = consumer->next_consumer) {
+        int len = asynchronous_fifo_len(consumer, consumer->read_ptr, consumer->write_ptr);
+        if (!consumer->reset && !consumer->stop_producing && len >= max_fifo_depth - 2 - n) {
+            consumer->stop_producing = 1;
+            if (consumer->stats != NULL) {
+                asynchronous_fifo_update_stats(consumer, ASYNCH_FIFO_STATS_OVERFLOW, n, len, fract_bits);
+            }
+        }
+    }
+    asm volatile("" ::: "memory");      // Stop the consumers before overwriting their frames
+    uint32_t write_ptr = asynchronous_fifo_write_frames(state, samples, n, state->shared_write_ptr);
+    state->shared_write_ptr = write_ptr;
+
+    for(asynchronous_fifo_t *consumer = state; consumer != NULL; consumer = consumer->next_consumer) {
+        int len = asynchronous_fifo_len(consumer, consumer->read_ptr, consumer->write_ptr);
+        int event = ASYNCH_FIFO_STATS_NONE;
+        if (consumer->reset) {
+            async_resets++;
+            uint32_t read_ptr = write_ptr - max_fifo_depth/2;
+            if (consumer->index_mask == ~0u && write_ptr < (uint32_t)max_fifo_depth/2) {
+                read_ptr += max_fifo_depth;
+            }
+            consumer->read_ptr = read_ptr;
+            asynchronous_fifo_init_producing_side(consumer);    // uses read_ptr
+            asm volatile("" ::: "memory");
+            asynchronous_fifo_reset_consumer_flags(consumer);   // Last step - clears reset
+            event = ASYNCH_FIFO_STATS_RESET;
+        } else if (!consumer->stop_producing && n) {
+            consumer->write_ptr = write_ptr;
+            if (consumer != state) {
+                asynchronous_fifo_measure_phase(consumer, n, timestamp, timestamp_fract, fract_bits);
+            } else {
+                if (consumer->adapt_margin != 0 && consumer->skip_ctr == 0) {
+                    asynchronous_fifo_adapt_depth(consumer, n, len);
+                }
+                asynchronous_fifo_measure(consumer, n, timestamp, timestamp_fract, fract_bits);
+            }
+            event = ASYNCH_FIFO_STATS_PUT;
+        }
+        if (consumer == state) {
+            consumer->ratio = (consumer->frequency_ratio + (1<<(K_SHIFT-1))) >> K_SHIFT;
         }
-        state->last_phase_error = phase_error;
+        if (consumer->stats != NULL && event != ASYNCH_FIFO_STATS_NONE) {
+            asynchronous_fifo_update_stats(consumer, event, n, len, fract_bits);
+        }
+    }
+    return state->ratio;
+}
+
+static int32_t asynchronous_fifo_put(asynchronous_fifo_t *state, int32_t *samples, int n,
+                                     int32_t timestamp, uint32_t timestamp_fract, int fract_bits) {
+    if (state->next_consumer != NULL) {
+        return asynchronous_fifo_broadcast_put(state, samples, n, timestamp, timestamp_fract, fract_bits);
+    }
+    uint32_t read_ptr = state->read_ptr;
+    uint32_t write_ptr = state->write_ptr;
+    int max_fifo_depth = state->max_fifo_depth;
+    int len = asynchronous_fifo_len(state, read_ptr, write_ptr);
+    int event = ASYNCH_FIFO_STATS_NONE;
+    if (state->reset) {
+        async_resets++;
+        asynchronous_fifo_init_producing_side(state);    // uses read_ptr
+        asynchronous_fifo_reset_consumer_flags(state);   // Last step - clears reset
+        event = ASYNCH_FIFO_STATS_RESET;
+    } else if (len >= max_fifo_depth - 2 - n) {
+        if (!state->stop_producing) {
+            event = ASYNCH_FIFO_STATS_OVERFLOW;
+        }
+        state->stop_producing = 1;
+    } else if (!state->stop_producing && n) {
+        state->write_ptr = asynchronous_fifo_write_frames(state, samples, n, write_ptr);
+        if (state->adapt_margin != 0 && state->skip_ctr == 0) {
+            asynchronous_fifo_adapt_depth(state, n, len);
+        }
+        asynchronous_fifo_measure(state, n, timestamp, timestamp_fract, fract_bits);
+        event = ASYNCH_FIFO_STATS_PUT;
     }
 #if defined(ASYNC_FIFO_XSCOPE_INSTRUMENTATION)
         xscope_int(3, len);
         xscope_int(4, state->frequency_ratio >> K_SHIFT);
 #endif
-    return (state->frequency_ratio + (1<<(K_SHIFT-1))) >> K_SHIFT;
+    state->ratio = (state->frequency_ratio + (1<<(K_SHIFT-1))) >> K_SHIFT;
+    if (state->stats != NULL && event != ASYNCH_FIFO_STATS_NONE) {
+        asynchronous_fifo_update_stats(state, event, n, len, fract_bits);
+    }
+    return state->ratio;
+}
+
+int32_t asynchronous_fifo_producer_put(asynchronous_fifo_t *state, int32_t *samples,
+                                  int n,
+                                  int32_t timestamp) {
+    return asynchronous_fifo_put(state, samples, n, timestamp, 0, 0);
+}
+
+int32_t asynchronous_fifo_producer_put_fract(asynchronous_fifo_t *state, int32_t *samples,
+                                             int n,
+                                             int32_t timestamp,
+                                             uint32_t timestamp_fract) {
+    return asynchronous_fifo_put(state, samples, n, timestamp, timestamp_fract,
+                                 ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS);
+}
+
+/**
+ * Function that returns whether the producer of a broadcast FIFO has stopped
+ * this consumer. Its unread frames may since have been overwritten for the
+ * other consumers, so it must reset rather than drain them. The frames of a
+ * plain FIFO are kept, so a stopped consumer drains them as before.
+ */
+static inline int asynchronous_fifo_overrun(asynchronous_fifo_t *state) {
+    return state->consumer_count > 1 && state->stop_producing;
 }
 
 /**
@@ -185,31 +937,130 @@ int32_t asynchronous_fifo_producer_put(asynchronous_fifo_t *state, int32_t *samp
  * If this is a problem then please use the return flag (0 = OK) to handle.
  */
 asynchronous_fifo_get_return_t asynchronous_fifo_consumer_get(asynchronous_fifo_t *state, int32_t *samples, int32_t timestamp) {
-    int read_ptr = state->read_ptr;
-    int write_ptr = state->write_ptr;
-    int max_fifo_depth = state->max_fifo_depth;
+    // Sample reset before read_ptr, the producer of a broadcast FIFO moves read_ptr while in reset
+    uint32_t reset = state->reset;
+    asm volatile("" ::: "memory");
+    uint32_t read_ptr = state->read_ptr;
+    uint32_t write_ptr = state->write_ptr;
     int channel_count = state->channel_count;
     int copy_mask = state->copy_mask;
-    int len = (write_ptr - read_ptr + max_fifo_depth) % max_fifo_depth;
+    int len = asynchronous_fifo_len(state, read_ptr, write_ptr);
+    uint32_t *frame = asynchronous_fifo_frame(state, asynchronous_fifo_index(state, read_ptr));
+    if (state->format != ASYNCH_FIFO_FORMAT_INT32) {
+        asynchronous_fifo_unpack_frame(state, samples, 1, frame);
+    } else {
 #ifdef __XS2A__
-    memcpy(samples, state->buffer + read_ptr * channel_count, channel_count * sizeof(int));
-    (void)copy_mask; // Remove unused var warning
+        memcpy(samples, frame, channel_count * sizeof(int));
+        (void)copy_mask; // Remove unused var warning
 #else
-    register int32_t *ptr asm("r11") = state->buffer + read_ptr * channel_count;
-    asm("vldr %0[0]" :: "r" (ptr));
-    asm("vstrpv %0[0], %1" :: "r" (samples), "r" (copy_mask));
+        register uint32_t *ptr asm("r11") = frame;
+        asm("vldr %0[0]" :: "r" (ptr));
+        asm("vstrpv %0[0], %1" :: "r" (samples), "r" (copy_mask));
 #endif
-    if (state->reset) {
+    }
+    if (reset) {
         return ASYNCH_FIFO_IN_RESET;
     }
-    if (len > 2) {
-        // TODO: use IF not %
-        read_ptr = (read_ptr + 1) % state->max_fifo_depth;
+    asm volatile("" ::: "memory");      // Check for an overrun after the frame is copied
+    if (len > 2 && !asynchronous_fifo_overrun(state)) {
+        read_ptr = asynchronous_fifo_next(state, read_ptr);
         state->read_ptr = read_ptr;
-        state->timestamps[read_ptr] = timestamp;
+        asynchronous_fifo_stamp(state, asynchronous_fifo_index(state, read_ptr), timestamp);
+        state->last_timestamp = timestamp;
         return ASYNCH_FIFO_OK;
     } else {
         state->reset = 1;                // The reset must happen in the other thread
+        if (state->stats != NULL) {
+            state->stats->underflows++;
+        }
     }
     return ASYNCH_FIFO_UNDERFLOW;
 }
+
+/**
+ * Bulk version of the consumer interface. The same ordering rules apply:
+ * write_ptr is sampled once, all frames are copied out before the
+ * timestamps and then read_ptr are updated, and the producer only ever
+ * looks at timestamps[write_ptr], which is at least two frames beyond the
+ * new read_ptr.
+ */
+asynchronous_fifo_get_return_t asynchronous_fifo_consumer_get_bulk(asynchronous_fifo_t *state, int32_t *samples,
+                                                                     int n, int32_t timestamp,
+                                                                     int planar_stride) {
+    uint32_t reset = state->reset;
+    asm volatile("" ::: "memory");
+    uint32_t read_ptr = state->read_ptr;
+    uint32_t write_ptr = state->write_ptr;
+    uint32_t read_index = asynchronous_fifo_index(state, read_ptr);
+    int max_fifo_depth = state->max_fifo_depth;
+    int channel_count = state->channel_count;
+    int len = asynchronous_fifo_len(state, read_ptr, write_ptr);
+    asynchronous_fifo_get_return_t ret = ASYNCH_FIFO_OK;
+
+    if (reset) {
+        ret = ASYNCH_FIFO_IN_RESET;
+    } else if (len <= n + 1 || asynchronous_fifo_overrun(state)) {
+        ret = ASYNCH_FIFO_UNDERFLOW;
+    }
+
+    // Interleaved frames are channel_count apart, planar channels planar_stride apart
+    int frame_stride = planar_stride ? 1 : channel_count;
+    int sample_stride = planar_stride ? planar_stride : 1;
+
+    if (ret == ASYNCH_FIFO_OK) {
+        // Frames up to the end of the buffer, then any that wrapped around
+        int n_first = max_fifo_depth - read_index;
+        if (n_first > n) {
+            n_first = n;
+        }
+        if (planar_stride || state->format != ASYNCH_FIFO_FORMAT_INT32) {
+            uint32_t *frame = asynchronous_fifo_frame(state, read_index);
+            for(int j = 0; j < n; j++) {
+                if (j == n_first) {
+                    frame = (uint32_t *)state->samples;
+                }
+                asynchronous_fifo_unpack_frame(state, samples + j * frame_stride, sample_stride, frame);
+                frame += state->frame_words;
+            }
+        } else {
+            memcpy(samples, state->samples + read_index * channel_count,
+                   n_first * channel_count * sizeof(int32_t));
+            memcpy(samples + n_first * channel_count, state->samples,
+                   (n - n_first) * channel_count * sizeof(int32_t));
+        }
+        // A broadcast consumer stopped during the copy may have copied overwritten frames
+        asm volatile("" ::: "memory");
+        if (asynchronous_fifo_overrun(state)) {
+            ret = ASYNCH_FIFO_UNDERFLOW;
+        }
+    }
+
+    if (ret != ASYNCH_FIFO_OK) {
+        if (ret == ASYNCH_FIFO_UNDERFLOW) {
+            state->reset = 1;                // The reset must happen in the other thread
+            if (state->stats != NULL) {
+                state->stats->underflows++;
+            }
+        }
+        // Repeat the frame at the read position, nothing is consumed
+        uint32_t *frame = asynchronous_fifo_frame(state, read_index);
+        for(int j = 0; j < n; j++) {
+            asynchronous_fifo_unpack_frame(state, samples + j * frame_stride, sample_stride, frame);
+        }
+        return ret;
+    }
+
+    // One timestamp per call, the intermediate frames are spaced evenly since the last get
+    int32_t step = asynchronous_fifo_div_n(state, asynchronous_fifo_ticks_between(timestamp, state->last_timestamp), n);
+    uint32_t frame_timestamp = (uint32_t)timestamp - (uint32_t)((n - 1) * step);
+    for(int j = 0; j < n - 1; j++) {
+        read_ptr = asynchronous_fifo_next(state, read_ptr);
+        asynchronous_fifo_stamp(state, asynchronous_fifo_index(state, read_ptr), frame_timestamp);
+        frame_timestamp += step;
+    }
+    read_ptr = asynchronous_fifo_next(state, read_ptr);
+    asynchronous_fifo_stamp(state, asynchronous_fifo_index(state, read_ptr), timestamp);
+    state->last_timestamp = timestamp;
+    state->read_ptr = read_ptr;
+    return ASYNCH_FIFO_OK;
+}
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
 
 #include "src.h"
 #include "src_ff3_ds3.h"
@@ -69,8 +70,8 @@ src_ff3_return_code_t src_ds3_init(src_ds3_ctrl_t* src_ds3_ctrl)
     }
 
     // Setup from FIRDS2 descriptor
-    src_ds3_ctrl->delay_len       = SRC_FF3_DS3_N_COEFS<<1;                                    // Double length for circular buffer simulation
-    src_ds3_ctrl->delay_wrap      = src_ds3_ctrl->delay_base + SRC_FF3_DS3_N_COEFS;
+    src_ds3_ctrl->delay_len       = SRC_FF3_DS3_DELAY_LEN;                                     // Filter window plus slack
+    src_ds3_ctrl->delay_wrap      = src_ds3_ctrl->delay_base + SRC_FF3_DS3_DELAY_SLACK;
     src_ds3_ctrl->delay_offset    = SRC_FF3_DS3_N_COEFS;
     src_ds3_ctrl->inner_loops     = (SRC_FF3_DS3_N_COEFS>>1) / SRC_FF3_N_LOOPS_PER_ASM;        // Right shift to 2 x 32bits read for coefs per inner loop
     src_ds3_ctrl->num_coeffs      = SRC_FF3_DS3_N_COEFS;
@@ -104,24 +105,22 @@ src_ff3_return_code_t src_ds3_proc(src_ds3_ctrl_t* src_ds3_ctrl)
     int             data0;
     __int64_t       accumulator;
 
-    // Get three new data samples to delay line (double write for circular buffer simulation)
+    // Get three new data samples to delay line (written just after the filter window)
     data0                    = *src_ds3_ctrl->in_data;
-    *src_ds3_ctrl->delay_pos                                       = data0;
     *(src_ds3_ctrl->delay_pos + src_ds3_ctrl->delay_offset)        = data0;
 
     data0                    = *(src_ds3_ctrl->in_data + 1);
-    *(src_ds3_ctrl->delay_pos + 1)                                 = data0;
     *(src_ds3_ctrl->delay_pos + src_ds3_ctrl->delay_offset + 1)    = data0;
 
     data0                    = *(src_ds3_ctrl->in_data + 2);
-    *(src_ds3_ctrl->delay_pos + 2)                                 = data0;
     *(src_ds3_ctrl->delay_pos + src_ds3_ctrl->delay_offset + 2)    = data0;
 
-    // Step delay with circular simulation (will also rewrite to control structure for next round)
-    // Note as delay line length is a multiple of 3 (because filter coefficients length is a multiple of 3)
-    // we only have to do the wrap around check after having written 3 input samples
+    // Step window (will also rewrite to control structure for next round)
+    // Note as the slack is a multiple of 3 we only have to check for it being used up
+    // after having written 3 input samples, then the window is moved back to the base
     src_ds3_ctrl->delay_pos += 3;
     if (src_ds3_ctrl->delay_pos >= src_ds3_ctrl->delay_wrap) {
+        memmove(src_ds3_ctrl->delay_base, src_ds3_ctrl->delay_pos, src_ds3_ctrl->delay_offset * sizeof(int));
         src_ds3_ctrl->delay_pos = src_ds3_ctrl->delay_base;
     }
 
@@ -8,6 +8,8 @@ extern "C" {
 #endif
 
 #define SRC_FF3_DS3_N_COEFS 144 // Number of coefficients must be a multiple of 6
+#define SRC_FF3_DS3_DELAY_SLACK ((SRC_FF3_DS3_N_COEFS / 12) * 3) // Extra delay line samples after the filter window (a multiple of 3)
+#define SRC_FF3_DS3_DELAY_LEN (SRC_FF3_DS3_N_COEFS + SRC_FF3_DS3_DELAY_SLACK) // Delay line length to allocate per channel
 
 /* Filters with "_b_" in their filenames have higher attenuation at
  * Nyquist (> 60dB compared with 20dB ) but with an earlier cutoff.
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
 
 #include "src.h"
 #include "src_ff3_os3.h"
@@ -56,8 +57,8 @@ src_ff3_return_code_t src_os3_init(src_os3_ctrl_t* src_os3_ctrl)
     }
 
     // Setup from FIROS2 descriptor
-    src_os3_ctrl->delay_len         = (SRC_FF3_OS3_N_COEFS/SRC_FF3_OS3_N_PHASES)<<1;                        // Double length for circular buffer simulation. x3 over-sampler, so only 1/3rd of coefs length needed
-    src_os3_ctrl->delay_wrap        = src_os3_ctrl->delay_base + (SRC_FF3_OS3_N_COEFS/SRC_FF3_OS3_N_PHASES);
+    src_os3_ctrl->delay_len         = SRC_FF3_OS3_DELAY_LEN;                                                    // Filter window plus slack. x3 over-sampler, so only 1/3rd of coefs length needed for the window
+    src_os3_ctrl->delay_wrap        = src_os3_ctrl->delay_base + SRC_FF3_OS3_DELAY_SLACK;
     src_os3_ctrl->delay_offset      = (SRC_FF3_OS3_N_COEFS/SRC_FF3_OS3_N_PHASES);
     src_os3_ctrl->inner_loops       = ((SRC_FF3_OS3_N_COEFS/SRC_FF3_OS3_N_PHASES)>>1) / SRC_FF3_N_LOOPS_PER_ASM;    // Right shift due to 2 x 32bits read for coefs per inner loop and x3 over-sampler, so only 1/3rd of coefs length needed
     src_os3_ctrl->num_coeffs        = SRC_FF3_OS3_N_COEFS;
@@ -90,13 +91,13 @@ src_ff3_return_code_t src_os3_sync(src_os3_ctrl_t* src_os3_ctrl)
 src_ff3_return_code_t src_os3_input(src_os3_ctrl_t* src_os3_ctrl)
 {
     // Write new input sample from control structure to delay line
-    // at both positions for circular buffer simulation
-    *src_os3_ctrl->delay_pos                                     = src_os3_ctrl->in_data;
+    // just after the filter window
     *(src_os3_ctrl->delay_pos + src_os3_ctrl->delay_offset)      = src_os3_ctrl->in_data;
 
-    // Step delay index with circular buffer simulation
+    // Step window, moving it back to the base once the slack is used up
     src_os3_ctrl->delay_pos                += 1;
     if (src_os3_ctrl->delay_pos >= src_os3_ctrl->delay_wrap) {
+        memmove(src_os3_ctrl->delay_base, src_os3_ctrl->delay_pos, src_os3_ctrl->delay_offset * sizeof(int));
         src_os3_ctrl->delay_pos = src_os3_ctrl->delay_base;
     }
 
@@ -376,6 +376,7 @@ ASRCReturnCodes_t                ASRC_init(asrc_ctrl_t* pasrc_ctrl)
     // Set number of input samples and input samples step
     pasrc_ctrl->sFIRF1Ctrl.uiNInSamples        = pasrc_ctrl->uiNInSamples;
     pasrc_ctrl->sFIRF1Ctrl.uiInStep            = pasrc_ctrl->uiNchannels;
+    pasrc_ctrl->uiOutStep                      = pasrc_ctrl->uiNchannels;
     // Set delay line base pointer
     if( psFiltersID->uiFID[ASRC_F1_INDEX] == FILTER_DEFS_ASRC_FIR_DS_ID )
         pasrc_ctrl->sFIRF1Ctrl.piDelayB            = pasrc_ctrl->psState->iDelayFIRShort;
@@ -494,7 +495,7 @@ ASRCReturnCodes_t                ASRC_proc_F1_F2(asrc_ctrl_t* pasrc_ctrl)
     pasrc_ctrl->sFIRF1Ctrl.piIn            = pasrc_ctrl->piIn;
 
     // F1 is always enabled, so call F1
-    __attribute__((fptrgroup("MRHF_G1")))
+    MRHF_G1_FPTRGROUP
     FIRReturnCodes_t ret = pasrc_ctrl->sFIRF1Ctrl.pvProc((int *)&pasrc_ctrl->sFIRF1Ctrl);
     if(ret != FIR_NO_ERROR)
         return ASRC_ERROR; 
@@ -503,7 +504,7 @@ ASRCReturnCodes_t                ASRC_proc_F1_F2(asrc_ctrl_t* pasrc_ctrl)
     if(pasrc_ctrl->sFIRF2Ctrl.eEnable == FIR_ON)
     {
         // F2 is enabled, so call F2
-        __attribute__((fptrgroup("MRHF_G1")))
+        MRHF_G1_FPTRGROUP
         FIRReturnCodes_t ret = pasrc_ctrl->sFIRF2Ctrl.pvProc((int *)&pasrc_ctrl->sFIRF2Ctrl);
         if(ret != FIR_NO_ERROR)
             return ASRC_ERROR; 
@@ -695,7 +696,7 @@ ASRCReturnCodes_t                ASRC_proc_dither(asrc_ctrl_t* pasrc_ctrl)
         uiR        = pasrc_ctrl->psState->uiRndSeed;
 
         // Loop through samples
-        for(ui = 0; ui < pasrc_ctrl->uiNASRCOutSamples * pasrc_ctrl->uiNchannels; ui += pasrc_ctrl->uiNchannels)
+        for(ui = 0; ui < pasrc_ctrl->uiNASRCOutSamples * pasrc_ctrl->uiOutStep; ui += pasrc_ctrl->uiOutStep)
         {
             // Compute dither sample (TPDF)
             iDither        = ASRC_DITHER_BIAS;
@@ -35,9 +35,28 @@
     // ---------------
     #define		   ASRC_FS_RATIO_UNIT_BIT					28
     #define        ASRC_STACK_LENGTH_MULT                (ASRC_N_CHANNELS * 4)                // Multiplier for stack length (stack length = this value x the number of input samples to process)
-    #define        ASRC_ADFIR_COEFS_LENGTH               FILTER_DEFS_ADFIR_PHASE_N_TAPS        // Length of AD FIR coefficients buffer
+    #ifndef ASRC_F3_BLOCK_LENGTH
+    #define        ASRC_F3_BLOCK_LENGTH                  8                                    // Maximum number of output samples computed per F3 block by asrc_process()
+    #endif
+    #define        ASRC_ADFIR_COEFS_LENGTH               (FILTER_DEFS_ADFIR_PHASE_N_TAPS * ASRC_F3_BLOCK_LENGTH)        // Length of AD FIR coefficients buffer (one set per F3 block output)
     #define		   ASRC_NOMINAL_FS_SCALE				     (1 << ASRC_FS_RATIO_UNIT_BIT)
 
+    // Spline coefficient cache
+    // ------------------------
+    // When enabled, asrc_process() keeps the adaptive coefficients of recent output times and reuses
+    // them when the same time (phase and alpha) comes round again. That only happens for an integral
+    // time step (uiTimeStepFract == 0), which in practice means a fixed ratio that is exactly nominal
+    // between rates of the same family, such as 48 to 48 or 48 to 192 kHz. Any other ratio bypasses
+    // the cache entirely: 44.1 to 48 kHz, any fs deviation and any ratio tracked by a rate control
+    // loop, so it does not help asrc_task. asrc_init_arena() places the cache in the arena,
+    // asrc_init() leaves it disabled.
+    #ifndef ASRC_SPLINE_CACHE_ENABLE
+    #define        ASRC_SPLINE_CACHE_ENABLE              0
+    #endif
+    #ifndef ASRC_SPLINE_CACHE_N_ENTRIES
+    #define        ASRC_SPLINE_CACHE_N_ENTRIES           8                                    // Number of cached coefficient sets, must be a power of 2
+    #endif
+
 
     // Parameter values
     // ----------------
@@ -118,12 +137,27 @@
         {
             long long                               pad_to_64b_alignment;               //Force compiler to 64b align
             unsigned int                            uiRndSeed;                                                // Dither random seeds current values
-            int                                        iDelayFIRLong[2 * FILTER_DEFS_FIR_MAX_TAPS_LONG];        // Doubled length for circular buffer simulation
-            int                                        iDelayFIRShort[2 * FILTER_DEFS_FIR_MAX_TAPS_SHORT];        // Doubled length for circular buffer simulation
-            int                                        iDelayADFIR[2 * FILTER_DEFS_ADFIR_PHASE_N_TAPS];        // Doubled length for circular buffer simulation
+            int                                        iDelayFIRLong[FIR_DELAY_LENGTH(FILTER_DEFS_FIR_MAX_TAPS_LONG)];    // Filter window plus slack
+            int                                        iDelayFIRShort[FIR_DELAY_LENGTH(FILTER_DEFS_FIR_MAX_TAPS_SHORT)];    // Filter window plus slack
+            int                                        iDelayADFIR[FIR_DELAY_LENGTH(FILTER_DEFS_ADFIR_PHASE_N_TAPS)];    // Filter window plus slack
         } asrc_state_t;
 
 
+#if (ASRC_SPLINE_CACHE_ENABLE)
+        // ASRC spline coefficient cache
+        // -----------------------------
+        // Direct mapped on the integer part of time (the phase). Shared by all channels of an instance.
+        typedef struct _ASRCSplineCache
+        {
+            long long                               pad_to_64b_alignment;               //Force compiler to 64b align
+            int                                     iCoefs[ASRC_SPLINE_CACHE_N_ENTRIES][FILTER_DEFS_ADFIR_PHASE_N_TAPS];   // Cached adaptive coefficients
+            int                                     iTimeInt[ASRC_SPLINE_CACHE_N_ENTRIES];          // Integer part of time of each entry (-1 if empty)
+            unsigned int                            uiTimeFract[ASRC_SPLINE_CACHE_N_ENTRIES];       // Fractional part of time of each entry
+            unsigned int                            uiNLookups;                         // Number of coefficient sets requested since asrc_init()
+            unsigned int                            uiNHits;                            // Number of those served from the cache
+        } asrc_spline_cache_t;
+#endif
+
         // ASRC Control structure
         // ----------------------
         typedef struct _ASRCCtrl
@@ -137,6 +171,7 @@
             ASRCFs_t                                eInFs;                                // Input sampling rate code
             int* unsafe                                piOut;                                // Output buffer poin ter (PCM, 32bits, 2 channels time domain interleaved data)
             unsigned int                            uiNASRCOutSamples;                    // Number of output samples produced during last call to the asynchronous processing function
+            unsigned int                            uiOutStep;                            // Output buffer step between the samples of a channel
             ASRCFs_t                                eOutFs;                                // Output sampling rate code
 
             FIRCtrl_t                                sFIRF1Ctrl;                            // F1 FIR controller
@@ -157,6 +192,9 @@
             asrc_state_t* unsafe                        psState;                            // Pointer to state structure
             int* unsafe                                piStack;                            // Pointer to stack buffer
             int* unsafe                                piADCoefs;                            // Pointer to AD coefficients
+#if (ASRC_SPLINE_CACHE_ENABLE)
+            asrc_spline_cache_t* unsafe                psSplineCache;                        // Pointer to spline coefficient cache (set by asrc_init_arena(), NULL if none)
+#endif
 #else
             long long                               pad_to_64b_alignment;               //Force compiler to 64b align
             unsigned int                            uiNchannels;                        // Number of channels in this instance
@@ -166,6 +204,7 @@
             ASRCFs_t                                eInFs;                                // Input sampling rate code
             int*                                    piOut;                                // Output buffer poin ter (PCM, 32bits, 2 channels time domain interleaved data)
             unsigned int                            uiNASRCOutSamples;                    // Number of output samples produced during last call to the asynchronous processing function
+            unsigned int                            uiOutStep;                            // Output buffer step between the samples of a channel
             ASRCFs_t                                eOutFs;                                // Output sampling rate code
 
             FIRCtrl_t                                sFIRF1Ctrl;                            // F1 FIR controller
@@ -186,6 +225,9 @@
             asrc_state_t*                            psState;                            // Pointer to state structure
             int*                                    piStack;                            // Pointer to stack buffer
             int*                                    piADCoefs;                            // Pointer to AD coefficients
+#if (ASRC_SPLINE_CACHE_ENABLE)
+            asrc_spline_cache_t*                    psSplineCache;                        // Pointer to spline coefficient cache (set by asrc_init_arena(), NULL if none)
+#endif
 #endif
         } asrc_ctrl_t;
 
@@ -196,10 +238,24 @@
                 typedef struct _asrc_adfir_coefs_t
                 {
                     long long       padding_to_64b;                           //Force 64b alignment
-                    int             iASRCADFIRCoefs[ASRC_ADFIR_COEFS_LENGTH]; //Adaptive FIR coefficients (one per instance)
+                    int             iASRCADFIRCoefs[ASRC_ADFIR_COEFS_LENGTH]; //Adaptive FIR coefficients (one block per instance)
                 } asrc_adfir_coefs_t;
 
 
+        // Caller provided memory for asrc_init_arena()
+        // --------------------------------------------
+        // Holds the adaptive filter coefficients (and spline cache) of an instance followed by the state and
+        // stack of each channel. Every part is a multiple of 64b so a 64b aligned arena keeps them all aligned.
+        #define        ASRC_STACK_LENGTH_PER_CHANNEL(n_in_samples)   (4 * (n_in_samples))           // Stack length of one channel for a block of n_in_samples
+#if (ASRC_SPLINE_CACHE_ENABLE)
+        #define        ASRC_ARENA_CACHE_BYTES                        (sizeof(asrc_spline_cache_t))
+#else
+        #define        ASRC_ARENA_CACHE_BYTES                        0
+#endif
+        #define        ASRC_ARENA_BYTES(n_channels, n_in_samples)    (sizeof(asrc_adfir_coefs_t) + ASRC_ARENA_CACHE_BYTES + \
+                                                                      (n_channels) * (sizeof(asrc_state_t) + ASRC_STACK_LENGTH_PER_CHANNEL(n_in_samples) * sizeof(int)))
+
+
 
 
 
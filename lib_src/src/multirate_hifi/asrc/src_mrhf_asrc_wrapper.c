@@ -3,10 +3,16 @@
 // General includes
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
+#if defined(__xcore__)
 #include <timer.h>
 #include "debug_print.h"
+#else
+#define debug_printf            printf
+#define delay_milliseconds(ms)
+#endif
 
 // ASRC includes
 #include "src.h"
@@ -14,8 +20,27 @@
 
 extern ASRCFsRatioConfigs_t     sFsRatioConfigs[ASRC_N_FS][ASRC_N_FS];
 
+// F3 output time schedule entry
+typedef struct _ASRCF3Sched
+{
+    unsigned int    uiDelayOffset;      // Number of block samples pushed before this output (window offset)
+    int             iTimeInt;           // Integer part of output time (phase)
+    unsigned int    uiTimeFract;        // Fractional part of output time (alpha)
+} ASRCF3Sched_t;
+
 #define DO_FS_BOUNDS_CHECK      1   //This is important to prevent pointers going out of bounds when invalid fs_ratios are sent
 
+#if (ASRC_SPLINE_CACHE_ENABLE)
+// Spline cache entry for a phase. The phase bits are folded so the phases of a power of two time step,
+// which are apart by a multiple of the cache size, do not all land on the same entry.
+static inline unsigned asrc_spline_cache_entry(int iTimeInt)
+{
+    unsigned uiPhase = (unsigned)iTimeInt;
+
+    return (uiPhase ^ (uiPhase >> 3) ^ (uiPhase >> 6)) & (ASRC_SPLINE_CACHE_N_ENTRIES - 1);
+}
+#endif
+
 static void asrc_error(int code)
 {
     debug_printf("ASRC_proc Error code %d\n", code);
@@ -39,6 +64,11 @@ uint64_t asrc_init(const fs_code_t sr_in, const fs_code_t sr_out, asrc_ctrl_t as
     if ((n_in_samples & 0x1) || (n_in_samples < 4)) asrc_error(100);
     if (n_channels_per_instance < 1) asrc_error(101);
 
+#if (ASRC_SPLINE_CACHE_ENABLE)
+    // Only asrc_init_arena() provides a spline coefficient cache
+    asrc_ctrl[0].psSplineCache = NULL;
+#endif
+
     for(ui = 0; ui < n_channels_per_instance; ui++)
     {
         // Set number of channels per instance
@@ -73,7 +103,68 @@ uint64_t asrc_init(const fs_code_t sr_in, const fs_code_t sr_out, asrc_ctrl_t as
     return (uint64_t)((((uint64_t)asrc_ctrl[0].uiFsRatio) << 32) | asrc_ctrl[0].uiFsRatio_lo);
 }
 
+uint64_t asrc_init_arena(const fs_code_t sr_in, const fs_code_t sr_out, asrc_ctrl_t asrc_ctrl[], const unsigned n_channels_per_instance,
+        const unsigned n_in_samples, const dither_flag_t dither_on_off, long long arena[], const unsigned arena_bytes)
+{
+    unsigned ui;
+    char* pcArena = (char*)arena;
+    int* piADCoefs;
+    uint64_t fs_ratio;
+#if (ASRC_SPLINE_CACHE_ENABLE)
+    asrc_spline_cache_t* psCache;
+#endif
+
+    //Check the arena is 64b aligned and large enough for this channel count and block size
+    if (n_channels_per_instance < 1) asrc_error(101);
+    if (n_in_samples & 0x3) asrc_error(104);
+    if (arena_bytes < ASRC_ARENA_BYTES(n_channels_per_instance, n_in_samples)) asrc_error(102);
+    if ((uintptr_t)pcArena & 0x7) asrc_error(103);
+
+    // Adaptive filter coefficients (and spline cache), shared by all channels of the instance
+    piADCoefs = ((asrc_adfir_coefs_t*)pcArena)->iASRCADFIRCoefs;
+    pcArena += sizeof(asrc_adfir_coefs_t);
+#if (ASRC_SPLINE_CACHE_ENABLE)
+    psCache = (asrc_spline_cache_t*)pcArena;
+    pcArena += sizeof(asrc_spline_cache_t);
+#endif
+
+    // State and stack of each channel
+    for(ui = 0; ui < n_channels_per_instance; ui++)
+    {
+        asrc_ctrl[ui].psState       = (asrc_state_t*)pcArena;
+        pcArena += sizeof(asrc_state_t);
+        asrc_ctrl[ui].piADCoefs     = piADCoefs;
+    }
+    for(ui = 0; ui < n_channels_per_instance; ui++)
+    {
+        asrc_ctrl[ui].piStack       = (int*)pcArena;
+        pcArena += ASRC_STACK_LENGTH_PER_CHANNEL(n_in_samples) * sizeof(int);
+    }
+
+    fs_ratio = asrc_init(sr_in, sr_out, asrc_ctrl, n_channels_per_instance, n_in_samples, dither_on_off);
+
+#if (ASRC_SPLINE_CACHE_ENABLE)
+    // Spline coefficient cache
+    // ------------------------
+    // Empty the cache (the time sequence restarts) and clear the hit counters
+    for(ui = 0; ui < ASRC_SPLINE_CACHE_N_ENTRIES; ui++)
+        psCache->iTimeInt[ui]   = -1;
+    psCache->uiNLookups         = 0;
+    psCache->uiNHits            = 0;
+    asrc_ctrl[0].psSplineCache  = psCache;
+#endif
+
+    return fs_ratio;
+}
+
 unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_t asrc_ctrl[]){
+    const unsigned n_channels_per_instance = asrc_ctrl[0].uiNchannels;
+
+    return asrc_process_strided(in_buff, out_buff, fs_ratio, asrc_ctrl, 0, n_channels_per_instance, n_channels_per_instance);
+}
+
+unsigned asrc_process_strided(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_t asrc_ctrl[],
+                              unsigned channel_offset, unsigned in_stride, unsigned out_stride){
 
     int ui, uj; //General counters
     int             uiSplCntr;  //Spline counter
@@ -109,9 +200,11 @@ unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_
 
 
 
-        // Set input and output data pointers
-        asrc_ctrl[ui].piIn          = in_buff + ui;
-        asrc_ctrl[ui].piOut         = out_buff + ui;
+        // Set input and output data pointers, the channels of this instance may be part of wider frames
+        asrc_ctrl[ui].piIn          = in_buff + channel_offset + ui;
+        asrc_ctrl[ui].piOut         = out_buff + channel_offset + ui;
+        asrc_ctrl[ui].sFIRF1Ctrl.uiInStep   = in_stride;
+        asrc_ctrl[ui].uiOutStep     = out_stride;
 
 
     // Process synchronous part (F1 + F2)
@@ -133,41 +226,87 @@ unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_
         asrc_ctrl[ui].uiNASRCOutSamples = 0;
     }
 
-    uiSplCntr = 0; // This is actually only used because of the bizarre mix of block and sample based processing
-
-    // Driven by samples produced during the synchronous phase
-    for(ui = 0; ui < asrc_ctrl[0].uiNSyncSamples; ui++)
+    // F3 is run block by block. A block covers the synchronous samples that fit in the
+    // remaining ADFIR delay line slack and at most ASRC_F3_BLOCK_LENGTH output samples.
+    // For each block the output time schedule (window offset, phase and alpha) is built
+    // first, then the adaptive coefficients for every output, then the MACCs.
+    uiSplCntr = 0;
+    ui = 0;
+    while((ui < asrc_ctrl[0].uiNSyncSamples) || (asrc_ctrl[0].iTimeInt < FILTER_DEFS_ADFIR_N_PHASES))
     {
-        // Push new samples into F3 delay line (input from stack) for each new "synchronous" sample (i.e. output of F1, respectively F2)
-        for(uj = 0; uj < n_channels_per_instance; uj++)
+        ASRCF3Sched_t   sSched[ASRC_F3_BLOCK_LENGTH];
+        unsigned        uiNBlock;
+        unsigned        uiNPushed;
+        unsigned        uiNSched;
+        unsigned        un;
+
+        // Synchronous samples that can be written after the window without moving it
+        uiNBlock        = asrc_ctrl[0].uiNSyncSamples - ui;
+        if(uiNBlock > (unsigned)(asrc_ctrl[0].sADFIRF3Ctrl.piDelayW - asrc_ctrl[0].sADFIRF3Ctrl.piDelayI))
+            uiNBlock    = (unsigned)(asrc_ctrl[0].sADFIRF3Ctrl.piDelayW - asrc_ctrl[0].sADFIRF3Ctrl.piDelayI);
+
+        // Output time schedule
+        // --------------------
+        // Same time stepping as sample based processing: each synchronous sample moves the
+        // time back by one input period, then outputs are produced while it is inside it.
+        // The schedule only depends on the first channel's time, the others share it.
+        uiNPushed       = 0;
+        uiNSched        = 0;
+        while(1)
         {
+            if(asrc_ctrl[0].iTimeInt < FILTER_DEFS_ADFIR_N_PHASES)
+            {
+                unsigned int    uiTemp;
+
+                if(uiNSched == ASRC_F3_BLOCK_LENGTH)
+                    break;
+
+                sSched[uiNSched].uiDelayOffset  = uiNPushed;
+                sSched[uiNSched].iTimeInt       = asrc_ctrl[0].iTimeInt;
+                sSched[uiNSched].uiTimeFract    = asrc_ctrl[0].uiTimeFract;
+                uiNSched++;
+
+                // Step to next output time (add integer and fractional parts)
+                asrc_ctrl[0].iTimeInt       += asrc_ctrl[0].iTimeStepInt;
+                uiTemp      = asrc_ctrl[0].uiTimeFract;
+                asrc_ctrl[0].uiTimeFract        += asrc_ctrl[0].uiTimeStepFract;
+                if(asrc_ctrl[0].uiTimeFract < uiTemp)
+                    asrc_ctrl[0].iTimeInt++;
+            }
+            else
+            {
+                if(uiNPushed == uiNBlock)
+                    break;
+
+                // Decrease next output time (this is an integer value, so no influence on fractional part)
+                asrc_ctrl[0].iTimeInt    -= FILTER_DEFS_ADFIR_N_PHASES;
+                uiNPushed++;
+            }
+        }
 
-            //The following is replicated/inlined code from ASRC_proc_F3_in_spl in ASRC.c
-            asrc_ctrl[uj].sADFIRF3Ctrl.iIn        = asrc_ctrl[uj].piStack[ui];
-
-            //The following is replicated/inlined code from ADFIR_proc_in_spl in FIR.c
-            // Double write to simulate circular buffer
-            *asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI                                  = asrc_ctrl[uj].sADFIRF3Ctrl.iIn;
-            *(asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI + asrc_ctrl[uj].sADFIRF3Ctrl.uiDelayO)        = asrc_ctrl[uj].sADFIRF3Ctrl.iIn;
-            // Step delay (with circular simulation)
-            asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI++;
-            if(asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI >= asrc_ctrl[uj].sADFIRF3Ctrl.piDelayW)
-                asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI               =asrc_ctrl[uj].sADFIRF3Ctrl.piDelayB;
-
-            // Decrease next output time (this is an integer value, so no influence on fractional part)
-            asrc_ctrl[uj].iTimeInt    -= FILTER_DEFS_ADFIR_N_PHASES;
-
+        // Push the block's synchronous samples into the F3 delay lines (input from stack)
+        // Same as ADFIR_proc_in_spl for each sample, with a single window move at the end.
+        for(uj = 0; uj < n_channels_per_instance; uj++)
+        {
+            int*            piDelay = asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI + asrc_ctrl[uj].sADFIRF3Ctrl.uiDelayO;
+            unsigned        uk;
 
+            for(uk = 0; uk < uiNPushed; uk++)
+                piDelay[uk]         = asrc_ctrl[uj].piStack[ui + uk];
+            if(uj != 0)
+                asrc_ctrl[uj].iTimeInt  -= FILTER_DEFS_ADFIR_N_PHASES * uiNPushed;
         }
-        // Run macc loop for F3
-        // Check if a new output sample needs to be produced
-        // Note that this will also update the adaptive filter coefficients
-        // These must be computed for one channel only and reused in the macc loop of other channels
-        while(asrc_ctrl[0].iTimeInt < FILTER_DEFS_ADFIR_N_PHASES)
+
+        // Adaptive filter coefficients
+        // ----------------------------
+        // One set per scheduled output, shared by all channels
+#if (ASRC_SPLINE_CACHE_ENABLE)
+        // Output times only come round again when the time step is integral, otherwise the cache is bypassed
+        asrc_spline_cache_t*    psCache = (asrc_ctrl[0].uiTimeStepFract == 0) ? asrc_ctrl[0].psSplineCache : NULL;
+#endif
+        for(un = 0; un < uiNSched; un++)
         {
-            unsigned int    uiTemp;
             int             iAlpha;
-
             int             iH[3]; //iH0, iH1, iH2;
             long long       i64Acc0;
             int*            piPhase0;
@@ -175,8 +314,26 @@ unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_
 
             // Compute adative coefficients spline factors
             // The fractional part of time gives alpha
-            iAlpha      = asrc_ctrl[0].uiTimeFract>>1;      // Now alpha can be seen as a signed number
+            iAlpha      = sSched[un].uiTimeFract>>1;      // Now alpha can be seen as a signed number
             i64Acc0 = (long long)iAlpha * (long long)iAlpha;
+            piADCoefs       = asrc_ctrl[0].piADCoefs + un * FILTER_DEFS_ADFIR_PHASE_N_TAPS;
+
+#if (ASRC_SPLINE_CACHE_ENABLE)
+            // Reuse the coefficients if this time is in the cache. They are copied into the block
+            // buffer rather than referenced so a later output of the block can replace the entry.
+            if(psCache != NULL)
+            {
+                unsigned                uiEntry = asrc_spline_cache_entry(sSched[un].iTimeInt);
+
+                psCache->uiNLookups++;
+                if((psCache->iTimeInt[uiEntry] == sSched[un].iTimeInt) && (psCache->uiTimeFract[uiEntry] == sSched[un].uiTimeFract))
+                {
+                    psCache->uiNHits++;
+                    memcpy(piADCoefs, psCache->iCoefs[uiEntry], FILTER_DEFS_ADFIR_PHASE_N_TAPS * sizeof(int));
+                    continue;
+                }
+            }
+#endif
 
 #if SRC_USE_VPU
             iH[2]           = (int)(i64Acc0>>32);
@@ -188,10 +345,7 @@ unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_
             iH[0]           = iH[0] + iH[2];                        // H2 = 0.5 - alpha + 0.5 * alpha * alpha
 
             // The integer part of time gives the phase
-            piPhase0        = &iADFirCoefs[0][asrc_ctrl[0].iTimeInt];
-            // These are calculated by the asm funcion  piPhase1        = piPhase0 + FILTER_DEFS_ADFIR_PHASE_N_TAPS;
-            //                                          piPhase2        = piPhase1 + FILTER_DEFS_ADFIR_PHASE_N_TAPS;
-            piADCoefs       = asrc_ctrl[0].piADCoefs;       // Given limited number of registers, this could be DP
+            piPhase0        = &iADFirCoefs[0][sSched[un].iTimeInt];
             // Apply spline coefficients to filter coefficients
             src_mrhf_spline_coeff_gen_inner_loop_asm_xs3(piPhase0, iH, piADCoefs, FILTER_DEFS_ADFIR_PHASE_N_TAPS);
 #else
@@ -204,59 +358,85 @@ unsigned asrc_process(int *in_buff, int *out_buff, uint64_t fs_ratio, asrc_ctrl_
             iH[2]           = iH[2] + iH[0];                        // H2 = 0.5 - alpha + 0.5 * alpha * alpha
 
             // The integer part of time gives the phase
-            piPhase0        = iADFirCoefs[asrc_ctrl[0].iTimeInt];
-            // These are calculated by the asm funcion  piPhase1        = piPhase0 + FILTER_DEFS_ADFIR_PHASE_N_TAPS;
-            //                                          piPhase2        = piPhase1 + FILTER_DEFS_ADFIR_PHASE_N_TAPS;
-            piADCoefs       = asrc_ctrl[0].piADCoefs;       // Given limited number of registers, this could be DP
-
+            piPhase0        = iADFirCoefs[sSched[un].iTimeInt];
             // Apply spline coefficients to filter coefficients
             src_mrhf_spline_coeff_gen_inner_loop_asm(piPhase0, iH, piADCoefs, FILTER_DEFS_ADFIR_PHASE_N_TAPS);
-
 #endif
 
-            // Step time for next output sample
-            // --------------------------------
-            // Step to next output time (add integer and fractional parts)
-            asrc_ctrl[0].iTimeInt       += asrc_ctrl[0].iTimeStepInt;
-            // For fractional part, this can be optimized using the add with carry instruction of XS2
-            uiTemp      = asrc_ctrl[0].uiTimeFract;
-            asrc_ctrl[0].uiTimeFract        += asrc_ctrl[0].uiTimeStepFract;
-            if(asrc_ctrl[0].uiTimeFract < uiTemp)
-                asrc_ctrl[0].iTimeInt++;
+#if (ASRC_SPLINE_CACHE_ENABLE)
+            if(psCache != NULL)
+            {
+                unsigned                uiEntry = asrc_spline_cache_entry(sSched[un].iTimeInt);
 
+                psCache->iTimeInt[uiEntry]      = sSched[un].iTimeInt;
+                psCache->uiTimeFract[uiEntry]   = sSched[un].uiTimeFract;
+                memcpy(psCache->iCoefs[uiEntry], piADCoefs, FILTER_DEFS_ADFIR_PHASE_N_TAPS * sizeof(int));
+            }
+#endif
+        }
 
-            // Not really needed, just for the beauty of it...
-            //asrc_ctrl[0+1].iTimeInt     = asrc_ctrl[0].iTimeInt;
-            //asrc_ctrl[0+1].uiTimeFract  = asrc_ctrl[0].uiTimeFract;
-
-            // Apply filter F3 with just computed adaptive coefficients
-            for(uj = 0; uj < n_channels_per_instance; uj++)    {
-
-                //The following is replicated/inlined code from ADFIR_F3_proc_macc in ASRC.c
-                asrc_ctrl[uj].sADFIRF3Ctrl.piOut      = (asrc_ctrl[uj].piOut + n_channels_per_instance * uiSplCntr);
+        // Apply filter F3
+        // ---------------
+#if SRC_USE_VPU
+        // Four channels per call so each half of the coefficients is loaded into the VPU once per group.
+        // A part filled group repeats the first channel's delay line and discards those results.
+        for(un = 0; un < uiNSched; un++)
+        {
+            for(uj = 0; uj < n_channels_per_instance; uj += 4)    {
+                int*            piData[4];
+                int             iData[4];
+                unsigned        uiNGroup = n_channels_per_instance - uj;
+                unsigned        uk;
+
+                if(uiNGroup > 4)
+                    uiNGroup = 4;
+                for(uk = 0; uk < 4; uk++)
+                    piData[uk]          = asrc_ctrl[uj + ((uk < uiNGroup) ? uk : 0)].sADFIRF3Ctrl.piDelayI + sSched[un].uiDelayOffset;
+
+                src_mrhf_adfir_inner_loop_asm_xs3_x4(piData, asrc_ctrl[uj].sADFIRF3Ctrl.piADCoefs + un * FILTER_DEFS_ADFIR_PHASE_N_TAPS, iData);
+
+                // Write outputs
+                for(uk = 0; uk < uiNGroup; uk++)
+                    *(asrc_ctrl[uj + uk].piOut + out_stride * (uiSplCntr + un))  = iData[uk];
+            }
+        }
+#else
+        for(uj = 0; uj < n_channels_per_instance; uj++)
+        {
+            int*            piOut   = asrc_ctrl[uj].piOut + out_stride * uiSplCntr;
 
+            for(un = 0; un < uiNSched; un++)
+            {
                 //The following is replicated/inlined code from ADFIR_proc_macc in FIR.c
                 int*            piData;
                 int*            piCoefs;
                 int             iData;
-                // Clear accumulator and set access pointers
-                piData                  = asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI;
-                piCoefs                 = asrc_ctrl[uj].sADFIRF3Ctrl.piADCoefs;
+                // Set access pointers
+                piData                  = asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI + sSched[un].uiDelayOffset;
+                piCoefs                 = asrc_ctrl[uj].sADFIRF3Ctrl.piADCoefs + un * FILTER_DEFS_ADFIR_PHASE_N_TAPS;
 
                 // Do FIR
-#if SRC_USE_VPU
-                src_mrhf_adfir_inner_loop_asm_xs3(piData, piCoefs, &iData, asrc_ctrl[uj].sADFIRF3Ctrl.uiNLoops);
-#else
-                if ((unsigned)piData & 0b0100) src_mrhf_adfir_inner_loop_asm_odd(piData, piCoefs, &iData, asrc_ctrl[uj].sADFIRF3Ctrl.uiNLoops);
+                if ((uintptr_t)piData & 0b0100) src_mrhf_adfir_inner_loop_asm_odd(piData, piCoefs, &iData, asrc_ctrl[uj].sADFIRF3Ctrl.uiNLoops);
                 else                               src_mrhf_adfir_inner_loop_asm(piData, piCoefs, &iData, asrc_ctrl[uj].sADFIRF3Ctrl.uiNLoops);
-#endif
 
                 // Write output
-                *(asrc_ctrl[uj].sADFIRF3Ctrl.piOut)       = iData;
-                asrc_ctrl[uj].uiNASRCOutSamples++;
+                *piOut                  = iData;
+                piOut                   += out_stride;
             }
-            uiSplCntr++; // This is actually only used because of the bizarre mix of block and sample based processing
         }
+#endif
+
+        // Step the windows past the block, moving them back to base once the slack is used up
+        for(uj = 0; uj < n_channels_per_instance; uj++)
+        {
+            asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI    += uiNPushed;
+            if(asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI >= asrc_ctrl[uj].sADFIRF3Ctrl.piDelayW)
+                asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI               = FIR_delay_rebase(asrc_ctrl[uj].sADFIRF3Ctrl.piDelayB, asrc_ctrl[uj].sADFIRF3Ctrl.piDelayI, asrc_ctrl[uj].sADFIRF3Ctrl.uiDelayO);
+            asrc_ctrl[uj].uiNASRCOutSamples        += uiNSched;
+        }
+
+        ui          += uiNPushed;
+        uiSplCntr   += uiNSched;
     }
 
 
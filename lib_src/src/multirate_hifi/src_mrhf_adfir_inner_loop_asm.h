@@ -6,5 +6,9 @@
 void src_mrhf_adfir_inner_loop_asm(int *piData, int *piCoefs, int iData[], int count);
 void src_mrhf_adfir_inner_loop_asm_odd(int *piData, int *piCoefs, int iData[], int count);
 void src_mrhf_adfir_inner_loop_asm_xs3(int *piData, int *piCoefs, int iData[], int count);
+#ifndef __XC__
+// Applies the same 16 adaptive coefficients to 4 delay lines (XS3 only)
+void src_mrhf_adfir_inner_loop_asm_xs3_x4(int *piData[4], int *piCoefs, int iData[4]);
+#endif
 
 #endif // _SRC_MRHF_ADFIR_INNER_LOOP_ASM_H_
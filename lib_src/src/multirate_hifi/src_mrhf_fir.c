@@ -19,6 +19,8 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
 
 // Optimised assembler inner loop functions
 #include "src_mrhf_fir_os_inner_loop_asm.h"
@@ -66,6 +68,24 @@
 //
 // ===========================================================================
 
+// ==================================================================== //
+// Function:        FIR_delay_rebase                                    //
+// Arguments:        int *piDelayB: Delay line base                        //
+//                    int *piDelayI: Current window start                    //
+//                    unsigned int uiDelayO: Window length                //
+// Return values:    New window start (piDelayB)                            //
+// Description:        Moves the filter window back to the delay line base    //
+//                    once the slack after it has been filled                //
+// ==================================================================== //
+int*                            FIR_delay_rebase(int* piDelayB, int* piDelayI, unsigned int uiDelayO)
+{
+    // Source and destination overlap when the slack is shorter than the window
+    memmove(piDelayB, piDelayI, uiDelayO * sizeof(int));
+
+    return piDelayB;
+}
+
+
 // ==================================================================== //
 // Function:        FIR_init_from_desc                                    //
 // Arguments:        FIRCtrl_t     *psFIRCtrl: Ctrl strct.                    //
@@ -121,8 +141,8 @@ FIRReturnCodes_t                FIR_init_from_desc(FIRCtrl_t* psFIRCtrl, FIRDesc
             psFIRCtrl->eEnable            = FIR_ON;
             psFIRCtrl->uiNOutSamples    = (psFIRCtrl->uiNInSamples)<<1;                        // Os2 FIR doubles the number of samples
             psFIRCtrl->pvProc            = (FIRReturnCodes_t (*)(int *)) FIR_proc_os2;
-            psFIRCtrl->uiDelayL            = psFIRDescriptor->uiNCoefs;                        // Double length for circular buffer simulation, but only half length due to OS2
-            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + (psFIRDescriptor->uiNCoefs>>1);
+            psFIRCtrl->uiDelayL            = FIR_DELAY_LENGTH(psFIRDescriptor->uiNCoefs>>1);    // Window is only half length due to OS2
+            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + FIR_DELAY_SLACK(psFIRDescriptor->uiNCoefs>>1);
             psFIRCtrl->uiDelayO            = psFIRDescriptor->uiNCoefs>>1;
             psFIRCtrl->uiNLoops            = psFIRDescriptor->uiNCoefs>>2;                        // Due to 2 x 32bits read for data and 4 x 32bits for coefs per inner loop
             psFIRCtrl->uiNCoefs            = psFIRDescriptor->uiNCoefs;
@@ -137,8 +157,8 @@ FIRReturnCodes_t                FIR_init_from_desc(FIRCtrl_t* psFIRCtrl, FIRDesc
             psFIRCtrl->eEnable            = FIR_ON;
             psFIRCtrl->uiNOutSamples    = psFIRCtrl->uiNInSamples;                            // Sync FIR does not change number of samples
             psFIRCtrl->pvProc            = (FIRReturnCodes_t (*)(int *)) FIR_proc_sync;
-            psFIRCtrl->uiDelayL            = psFIRDescriptor->uiNCoefs<<1;                        // Double length for circular buffer simulation
-            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + psFIRDescriptor->uiNCoefs;
+            psFIRCtrl->uiDelayL            = FIR_DELAY_LENGTH(psFIRDescriptor->uiNCoefs);        // Window plus slack
+            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + FIR_DELAY_SLACK(psFIRDescriptor->uiNCoefs);
             psFIRCtrl->uiDelayO            = psFIRDescriptor->uiNCoefs;
             psFIRCtrl->uiNLoops            = psFIRDescriptor->uiNCoefs>>1;                        // Due to 2 x 32bits read for data and coefs per inner loop
             psFIRCtrl->uiNCoefs            = psFIRDescriptor->uiNCoefs;
@@ -152,8 +172,8 @@ FIRReturnCodes_t                FIR_init_from_desc(FIRCtrl_t* psFIRCtrl, FIRDesc
             psFIRCtrl->eEnable            = FIR_ON;
             psFIRCtrl->uiNOutSamples    = psFIRCtrl->uiNInSamples>>1;                        // Ds2 FIR divides the number of samples by two
             psFIRCtrl->pvProc            = (FIRReturnCodes_t (*)(int *)) FIR_proc_ds2;
-            psFIRCtrl->uiDelayL            = psFIRDescriptor->uiNCoefs<<1;                        // Double length for circular buffer simulation
-            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + psFIRDescriptor->uiNCoefs;
+            psFIRCtrl->uiDelayL            = FIR_DELAY_LENGTH(psFIRDescriptor->uiNCoefs);        // Window plus slack
+            psFIRCtrl->piDelayW            = psFIRCtrl->piDelayB + FIR_DELAY_SLACK(psFIRDescriptor->uiNCoefs);
             psFIRCtrl->uiDelayO            = psFIRDescriptor->uiNCoefs;
             psFIRCtrl->uiNLoops            = psFIRDescriptor->uiNCoefs>>1;                        // Due to 2 x 32bits read for data and coefs per inner loop
             psFIRCtrl->uiNCoefs            = psFIRDescriptor->uiNCoefs;
@@ -205,7 +225,7 @@ FIRReturnCodes_t                FIR_sync(FIRCtrl_t* psFIRCtrl)
 //                    FIR_ERROR on failure                                //
 // Description:        Processes the FIR in over-sample by 2 mode            //
 // ==================================================================== //
- __attribute__((fptrgroup("MRHF_G1")))
+ MRHF_G1_FPTRGROUP
 FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
 {
     int*            piIn        = psFIRCtrl->piIn;
@@ -225,17 +245,15 @@ FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
 
     for(ui = 0; ui < psFIRCtrl->uiNInSamples; ui+=2) //Note step by 2 as inner loop unrolled twice
     {
-        // Get new data sample to delay line (double write for circular buffer simulation) with step
+        // Get new data sample to delay line (written just after the window) with step
         iData[0]                    = *piIn;
         piIn                    += uiInStep;
-        // Double write to simulate circular buffer
-        *piDelayI               = iData[0];
         *(piDelayI + uiDelayO)  = iData[0];
 
-        // Step delay (with circular simulation)
+        // Step window (moving it back to base once the slack is used up)
         piDelayI++;
         if(piDelayI >= piDelayW)
-            piDelayI                = piDelayB;
+            piDelayI                = FIR_delay_rebase(piDelayB, piDelayI, uiDelayO);
 
         // Set access pointers
         piData                  = piDelayI;
@@ -245,7 +263,7 @@ FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
 #if SRC_USE_VPU
         src_mrhf_fir_os_inner_loop_asm_xs3(piData, piCoefs, iData, uiNLoops);
 #else
-        if ((unsigned)piData & 0b0100)
+        if ((uintptr_t)piData & 0b0100)
             src_mrhf_fir_os_inner_loop_asm_odd(piData, piCoefs, iData, uiNLoops);
         else
             src_mrhf_fir_os_inner_loop_asm(piData, piCoefs, iData, uiNLoops);
@@ -258,17 +276,15 @@ FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
         *piOut                  = iData[0];
         piOut                   += uiOutStep;
 
-        // Get new data sample to delay line (double write for circular buffer simulation) with step
+        // Get new data sample to delay line (written just after the window) with step
         iData[0]                    = *piIn;
         piIn                    += uiInStep;
-        // Double write to simulate circular buffer
-        *piDelayI               = iData[0];
         *(piDelayI + uiDelayO)  = iData[0];
 
-        // Step delay (with circular simulation)
+        // Step window (moving it back to base once the slack is used up)
         piDelayI++;
         if(piDelayI >= piDelayW)
-            piDelayI                = piDelayB;
+            piDelayI                = FIR_delay_rebase(piDelayB, piDelayI, uiDelayO);
 
         // Set access pointers
         piData                  = piDelayI;
@@ -278,7 +294,7 @@ FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
 #if SRC_USE_VPU
         src_mrhf_fir_os_inner_loop_asm_xs3(piData, piCoefs, iData, uiNLoops);
 #else
-        if ((unsigned)piData & 0b0100)
+        if ((uintptr_t)piData & 0b0100)
             src_mrhf_fir_os_inner_loop_asm_odd(piData, piCoefs, iData, uiNLoops);
         else
             src_mrhf_fir_os_inner_loop_asm(piData, piCoefs, iData, uiNLoops);
@@ -305,7 +321,7 @@ FIRReturnCodes_t                FIR_proc_os2(FIRCtrl_t* psFIRCtrl)
 //                    FIR_ERROR on failure                                //
 // Description:        Processes the FIR in asynchronous mode                //
 // ==================================================================== //
-__attribute__((fptrgroup("MRHF_G1")))
+MRHF_G1_FPTRGROUP
 FIRReturnCodes_t                FIR_proc_sync(FIRCtrl_t* psFIRCtrl)
 {
     int*            piIn        = psFIRCtrl->piIn;
@@ -325,16 +341,14 @@ FIRReturnCodes_t                FIR_proc_sync(FIRCtrl_t* psFIRCtrl)
 
     for(ui = 0; ui < psFIRCtrl->uiNInSamples; ui++)
     {
-        // Get new data sample to delay line (double write for circular buffer simulation) with step
+        // Get new data sample to delay line (written just after the window) with step
         iData0                    = *piIn;
         piIn                    += uiInStep;
-        // Double write to simulate circular buffer
-        *piDelayI                = iData0;
         *(piDelayI + uiDelayO)    = iData0;
-        // Step delay (with circular simulation)
+        // Step window (moving it back to base once the slack is used up)
         piDelayI++;
         if(piDelayI >= piDelayW)
-            piDelayI                = piDelayB;
+            piDelayI                = FIR_delay_rebase(piDelayB, piDelayI, uiDelayO);
 
         // Clear accumulator and set access pointers
         piData                    = piDelayI;
@@ -343,7 +357,7 @@ FIRReturnCodes_t                FIR_proc_sync(FIRCtrl_t* psFIRCtrl)
 #if SRC_USE_VPU
         src_mrhf_fir_inner_loop_asm_xs3(piData, piCoefs, &iData0, uiNLoops);
 #else
-        if ((unsigned)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, &iData0, uiNLoops);
+        if ((uintptr_t)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, &iData0, uiNLoops);
         else src_mrhf_fir_inner_loop_asm(piData, piCoefs, &iData0, uiNLoops);
 #endif
 
@@ -366,7 +380,7 @@ FIRReturnCodes_t                FIR_proc_sync(FIRCtrl_t* psFIRCtrl)
 //                    FIR_ERROR on failure                                //
 // Description:        Processes the FIR in down-sample by 2 mode            //
 // ==================================================================== //
-__attribute__((fptrgroup("MRHF_G1")))
+MRHF_G1_FPTRGROUP
 FIRReturnCodes_t                FIR_proc_ds2(FIRCtrl_t* psFIRCtrl)
 {
     int*            piIn        = psFIRCtrl->piIn;
@@ -386,20 +400,17 @@ FIRReturnCodes_t                FIR_proc_ds2(FIRCtrl_t* psFIRCtrl)
 
     for(ui = 0; ui < psFIRCtrl->uiNInSamples>>1; ui++)
     {
-        // Get two new data samples to delay line (double write for circular buffer simulation), with input buffer step
+        // Get two new data samples to delay line (written just after the window), with input buffer step
         iData0                    = *piIn;
         piIn                    += uiInStep;
         iData1                    = *piIn;
         piIn                    += uiInStep;
-        // Double write to simulate circular buffer with DUAL store instruction
-        *piDelayI                = iData0;
-        *(piDelayI + 1)            = iData1;
         *(piDelayI + uiDelayO)    = iData0;
         *(piDelayI + uiDelayO + 1)    = iData1;
-        // Step delay with circular simulation
+        // Step window (moving it back to base once the slack is used up, slack is a multiple of 2)
         piDelayI                += 2;
         if(piDelayI >= piDelayW)
-            piDelayI                = piDelayB;
+            piDelayI                = FIR_delay_rebase(piDelayB, piDelayI, uiDelayO);
 
         // Clear accumulator and set access pointers
         piData                    = piDelayI;
@@ -407,7 +418,7 @@ FIRReturnCodes_t                FIR_proc_ds2(FIRCtrl_t* psFIRCtrl)
 #if SRC_USE_VPU
         src_mrhf_fir_inner_loop_asm_xs3(piData, piCoefs, &iData0, uiNLoops);
 #else
-        if ((unsigned)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, &iData0, uiNLoops);
+        if ((uintptr_t)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, &iData0, uiNLoops);
         else src_mrhf_fir_inner_loop_asm(piData, piCoefs, &iData0, uiNLoops);
 #endif
         // Write output with step
@@ -450,8 +461,8 @@ FIRReturnCodes_t                ADFIR_init_from_desc(ADFIRCtrl_t* psADFIRCtrl, A
 
     uiPhaseLength                    = psADFIRDescriptor->uiNCoefsPerPhase;
     // Setup ADFIR
-    psADFIRCtrl->uiDelayL            = uiPhaseLength<<1;                    // Double length for circular buffer simulation
-    psADFIRCtrl->piDelayW            = psADFIRCtrl->piDelayB + uiPhaseLength;
+    psADFIRCtrl->uiDelayL            = FIR_DELAY_LENGTH(uiPhaseLength);    // Window plus slack
+    psADFIRCtrl->piDelayW            = psADFIRCtrl->piDelayB + FIR_DELAY_SLACK(uiPhaseLength);
     psADFIRCtrl->uiDelayO            = uiPhaseLength;
     psADFIRCtrl->uiNLoops            = uiPhaseLength>>1;                    // Due to 2 x 32bits read for data and coefs per inner loop
 
@@ -492,13 +503,12 @@ FIRReturnCodes_t                ADFIR_sync(ADFIRCtrl_t* psADFIRCtrl)
 // ==================================================================== //
 FIRReturnCodes_t                ADFIR_proc_in_spl(ADFIRCtrl_t* psADFIRCtrl)
 {
-    // Double write to simulate circular buffer
-    *psADFIRCtrl->piDelayI                                    = psADFIRCtrl->iIn;
+    // Write just after the window
     *(psADFIRCtrl->piDelayI + psADFIRCtrl->uiDelayO)        = psADFIRCtrl->iIn;
-    // Step delay (with circular simulation)
+    // Step window (moving it back to base once the slack is used up)
     psADFIRCtrl->piDelayI++;
     if(psADFIRCtrl->piDelayI >= psADFIRCtrl->piDelayW)
-        psADFIRCtrl->piDelayI                = psADFIRCtrl->piDelayB;
+        psADFIRCtrl->piDelayI                = FIR_delay_rebase(psADFIRCtrl->piDelayB, psADFIRCtrl->piDelayI, psADFIRCtrl->uiDelayO);
 
     return FIR_NO_ERROR;
 }
@@ -523,8 +533,12 @@ FIRReturnCodes_t                ADFIR_proc_macc(ADFIRCtrl_t* psADFIRCtrl)
     // Clear accumulator and set access pointers
     piData                    = psADFIRCtrl->piDelayI;
     piCoefs                    = psADFIRCtrl->piADCoefs;
-    if ((unsigned)piData & 0b0100) src_mrhf_adfir_inner_loop_asm_odd(piData, piCoefs, &iData, psADFIRCtrl->uiNLoops);
+#if SRC_USE_VPU
+    src_mrhf_adfir_inner_loop_asm_xs3(piData, piCoefs, &iData, psADFIRCtrl->uiNLoops);
+#else
+    if ((uintptr_t)piData & 0b0100) src_mrhf_adfir_inner_loop_asm_odd(piData, piCoefs, &iData, psADFIRCtrl->uiNLoops);
     else                               src_mrhf_adfir_inner_loop_asm(piData, piCoefs, &iData, psADFIRCtrl->uiNLoops);
+#endif
 
     // Write output
     *(psADFIRCtrl->piOut)        = iData;
@@ -593,8 +607,8 @@ FIRReturnCodes_t                PPFIR_init_from_desc(PPFIRCtrl_t* psPPFIRCtrl, P
 
     // Setup PPFIR
     psPPFIRCtrl->eEnable            = FIR_ON;
-    psPPFIRCtrl->uiDelayL            = uiPhaseLength<<1;                                    // Double length for circular buffer simulation
-    psPPFIRCtrl->piDelayW            = psPPFIRCtrl->piDelayB + uiPhaseLength;
+    psPPFIRCtrl->uiDelayL            = FIR_DELAY_LENGTH(uiPhaseLength);                    // Window plus slack
+    psPPFIRCtrl->piDelayW            = psPPFIRCtrl->piDelayB + FIR_DELAY_SLACK(uiPhaseLength);
     psPPFIRCtrl->uiDelayO            = uiPhaseLength;
     psPPFIRCtrl->uiNLoops            = uiPhaseLength>>1;                                    // Due to 2 x 32bits read for data and coefs per inner loop
     psPPFIRCtrl->uiNCoefs            = psPPFIRDescriptor->uiNCoefs;
@@ -673,16 +687,14 @@ FIRReturnCodes_t                PPFIR_proc(PPFIRCtrl_t* psPPFIRCtrl)
 
     for(ui = 0; ui < psPPFIRCtrl->uiNInSamples; ui++)
     {
-        // Get new data sample to delay line (double write for circular buffer simulation) with step
+        // Get new data sample to delay line (written just after the window) with step
         iData[0]                    = *piIn;
         piIn                    += uiInStep;
-        // Double write to simulate circular buffer
-        *piDelayI                = iData[0];
         *(piDelayI + uiDelayO)    = iData[0];
-        // Step delay (with circular simulation)
+        // Step window (moving it back to base once the slack is used up)
         piDelayI++;
         if(piDelayI >= piDelayW)
-            piDelayI                = piDelayB;
+            piDelayI                = FIR_delay_rebase(piDelayB, piDelayI, uiDelayO);
 
         // Do while the current phase coefficient pointer points to phase coefficients
         // This is equivalent to know if the output sample is between the current and next input sample
@@ -693,8 +705,12 @@ FIRReturnCodes_t                PPFIR_proc(PPFIRCtrl_t* psPPFIRCtrl)
             piData                    = piDelayI;
             piCoefs                    = piCoefsB + uiCoefsPhase;
 
-            if ((unsigned)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, iData, uiNLoops);
+#if SRC_USE_VPU
+            src_mrhf_fir_inner_loop_asm_xs3(piData, piCoefs, iData, uiNLoops);
+#else
+            if ((uintptr_t)piData & 0b0100) src_mrhf_fir_inner_loop_asm_odd(piData, piCoefs, iData, uiNLoops);
             else src_mrhf_fir_inner_loop_asm(piData, piCoefs, iData, uiNLoops);
+#endif
 
 
             // Write output with step
@@ -26,6 +26,15 @@
 /// (on xcore) Force variable to double word alignment
 #ifndef DWORD_ALIGNED
 #  define DWORD_ALIGNED  ALIGNMENT(8)
+#endif
+
+/// (on xcore) Function pointer group of the FIR processing functions
+#ifndef MRHF_G1_FPTRGROUP
+#  ifdef __xcore__
+#    define MRHF_G1_FPTRGROUP  __attribute__((fptrgroup("MRHF_G1")))
+#  else
+#    define MRHF_G1_FPTRGROUP
+#  endif
 #endif
     // ===========================================================================
     //
@@ -36,6 +45,25 @@
     // General defines
     // ---------------
 
+    // Delay lines are linear buffers holding the filter window followed by some slack.
+    // Each new sample is written once, just after the window, and when the slack has
+    // been used up the window is copied back to the start of the buffer. A larger slack
+    // means fewer copies, a smaller one less state memory: with a slack of 1/2^s of the
+    // window, a delay line is (1 + 1/2^s) windows long and copies 2^s words per sample on
+    // average, against 2 windows and one extra store per sample for a double-written
+    // circular buffer. The default of s = 0 keeps that memory use and averages one word
+    // copied per sample. s = 2 saves 3/8 of the delay line memory (156 words per SSRC or
+    // ASRC channel) for four words copied per sample. Whatever s is, the call that moves
+    // a window copies all of it, up to 160 words for the longest FIR, so the worst case
+    // call is that much longer than the average; the peak_ticks column of src_bench
+    // measures it. It sizes the SSRC and ASRC state structures, so override it for the
+    // whole application, not just the library.
+    #ifndef FIR_DELAY_SLACK_SHIFT
+    #define        FIR_DELAY_SLACK_SHIFT                0                                    // Slack is the whole window
+    #endif
+    #define        FIR_DELAY_SLACK(n)                    ((((n) >> FIR_DELAY_SLACK_SHIFT) < 2) ? 2 : (((n) >> FIR_DELAY_SLACK_SHIFT) & ~0x1))    // Slack for a window of n samples (even and at least 2, for the DS2 dual write)
+    #define        FIR_DELAY_LENGTH(n)                    ((n) + FIR_DELAY_SLACK(n))            // Delay line length for a window of n samples
+
 
     // Parameter values
     // ----------------
@@ -112,10 +140,10 @@
             FIRReturnCodes_t * unsafe                    pvProc;            // Processing function address
 
             int* unsafe                                piDelayB;        // Pointer to delay line base
-            unsigned int                            uiDelayL;        // Total length of delay line
-            int* unsafe                                piDelayI;        // Pointer to current position in delay line
-            int* unsafe                                piDelayW;        // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;        // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;        // Total length of delay line (window + slack)
+            int* unsafe                                piDelayI;        // Pointer to start of the filter window in delay line
+            int* unsafe                                piDelayW;        // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;        // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;        // Number of inner loop iterations
             unsigned int                            uiNCoefs;        // Number of coefficients
@@ -140,10 +168,10 @@
             int* unsafe                                piOut;                // Pointer to output sample
 
             int* unsafe                                piDelayB;            // Pointer to delay line base
-            unsigned int                            uiDelayL;            // Total length of delay line
-            int* unsafe                                piDelayI;            // Pointer to current position in delay line
-            int* unsafe                                piDelayW;            // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;            // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;            // Total length of delay line (window + slack)
+            int* unsafe                                piDelayI;            // Pointer to start of the filter window in delay line
+            int* unsafe                                piDelayW;            // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;            // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;            // Number of inner loop iterations
             int* unsafe                                piADCoefs;            // Pointer to adaptive coefficients
@@ -173,10 +201,10 @@
             unsigned int                            uiOutStep;            // Step between output data samples
 
             int* unsafe                                piDelayB;            // Pointer to delay line base
-            unsigned int                            uiDelayL;            // Total length of delay line
-            int* unsafe                                piDelayI;            // Pointer to current position in delay line
-            int* unsafe                                piDelayW;            // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;            // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;            // Total length of delay line (window + slack)
+            int* unsafe                                piDelayI;            // Pointer to start of the filter window in delay line
+            int* unsafe                                piDelayW;            // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;            // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;            // Number of inner loop iterations
             unsigned int                            uiNCoefs;            // Number of coefficients
@@ -211,14 +239,14 @@
             unsigned int                            uiNOutSamples;    // Number of output samples produced
             unsigned int                            uiOutStep;        // Step between output data samples
 
-__attribute__((fptrgroup("MRHF_G1")))
+MRHF_G1_FPTRGROUP
             FIRReturnCodes_t                         (*pvProc)(int *);// Processing function address
 
             int*                                    piDelayB;        // Pointer to delay line base
-            unsigned int                            uiDelayL;        // Total length of delay line
-            int*                                    piDelayI;        // Pointer to current position in delay line
-            int*                                    piDelayW;        // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;        // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;        // Total length of delay line (window + slack)
+            int*                                    piDelayI;        // Pointer to start of the filter window in delay line
+            int*                                    piDelayW;        // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;        // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;        // Number of inner loop iterations
             unsigned int                            uiNCoefs;        // Number of coefficients
@@ -242,10 +270,10 @@ __attribute__((fptrgroup("MRHF_G1")))
             int*                                    piOut;                // Pointer to output sample
 
             int*                                    piDelayB;            // Pointer to delay line base
-            unsigned int                            uiDelayL;            // Total length of delay line
-            int*                                    piDelayI;            // Pointer to current position in delay line
-            int*                                    piDelayW;            // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;            // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;            // Total length of delay line (window + slack)
+            int*                                    piDelayI;            // Pointer to start of the filter window in delay line
+            int*                                    piDelayW;            // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;            // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;            // Number of inner loop iterations
             int*                                    piADCoefs;            // Pointer to adaptive coefficients
@@ -275,10 +303,10 @@ __attribute__((fptrgroup("MRHF_G1")))
             unsigned int                            uiOutStep;            // Step between output data samples
 
             int*                                    piDelayB;            // Pointer to delay line base
-            unsigned int                            uiDelayL;            // Total length of delay line
-            int*                                    piDelayI;            // Pointer to current position in delay line
-            int*                                    piDelayW;            // Delay buffer wrap around address (for circular buffer simulation)
-            unsigned int                            uiDelayO;            // Delay line offset for second write (for circular buffer simulation)
+            unsigned int                            uiDelayL;            // Total length of delay line (window + slack)
+            int*                                    piDelayI;            // Pointer to start of the filter window in delay line
+            int*                                    piDelayW;            // Last window start before the window is moved back to base
+            unsigned int                            uiDelayO;            // Window length, offset of the write position from piDelayI
 
             unsigned int                            uiNLoops;            // Number of inner loop iterations
             unsigned int                            uiNCoefs;            // Number of coefficients
@@ -407,6 +435,16 @@ __attribute__((fptrgroup("MRHF_G1")))
         // Description:        Processes the PPFIR polyphase filter                 //
         // ==================================================================== //
         FIRReturnCodes_t                PPFIR_proc(PPFIRCtrl_t* psPPFIRCtrl);
+
+        // ==================================================================== //
+        // Function:        FIR_delay_rebase                                    //
+        // Arguments:        int *piDelayB: Delay line base                        //
+        //                    int *piDelayI: Current window start                    //
+        //                    unsigned int uiDelayO: Window length                //
+        // Return values:    New window start (piDelayB)                            //
+        // Description:        Moves the filter window back to the delay line base    //
+        // ==================================================================== //
+        int*                            FIR_delay_rebase(int* piDelayB, int* piDelayI, unsigned int uiDelayO);
     #endif // nINCLUDE_FROM_ASM
 
 #endif // _SRC_MRHF_FIR_H
@@ -0,0 +1,184 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// x86 AVX2 implementations of the multirate_hifi inner loops
+//
+// _mm256_mul_epi32 gives four signed 32x32->64 products per instruction and
+// the 64-bit lanes wrap exactly as the xcore MACCS accumulator does, so the
+// results are bit-exact with the scalar C and XS2 assembler versions.
+// Compiled with the avx2 target attribute so the rest of the library does
+// not require AVX2; src_mrhf_inner_loop_c.c only calls these after checking
+// the CPU.
+//
+// ===========================================================================
+// ===========================================================================
+#include "src_mrhf_inner_loop_c.h"
+
+#if !defined(__xcore__) && SRC_MRHF_HAVE_AVX2
+
+// ===========================================================================
+//
+// Includes
+//
+// ===========================================================================
+#include <immintrin.h>
+#include "src_mrhf_int_arithmetic.h"
+
+// ===========================================================================
+//
+// Defines
+//
+// ===========================================================================
+#define SRC_MRHF_AVX2       __attribute__((target("avx2")))
+
+// ===========================================================================
+//
+// Local Functions implementations
+//
+// ===========================================================================
+
+// Multiply-accumulate 8 x 32i pairs into the 4 x 64i lanes of *pAcc
+SRC_MRHF_AVX2 static inline void src_mrhf_macc8_avx2(__m256i *pAcc, const int *piX, const int *piY)
+{
+    __m256i     x = _mm256_loadu_si256((const __m256i *)piX);
+    __m256i     y = _mm256_loadu_si256((const __m256i *)piY);
+
+    // Even elements directly, odd elements moved down into the low half of each lane
+    *pAcc = _mm256_add_epi64(*pAcc, _mm256_mul_epi32(x, y));
+    *pAcc = _mm256_add_epi64(*pAcc, _mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32)));
+}
+
+// Sum of the 4 x 64i lanes
+SRC_MRHF_AVX2 static inline __int64 src_mrhf_hsum_avx2(__m256i acc)
+{
+    __m128i     s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+
+    return (__int64)_mm_cvtsi128_si64(s) + (__int64)_mm_extract_epi64(s, 1);
+}
+
+// Plain dot product over n_taps (a multiple of 16)
+SRC_MRHF_AVX2 static inline __int64 src_mrhf_dot_avx2(const int *piData, const int *piCoefs, int n_taps)
+{
+    __m256i     acc0 = _mm256_setzero_si256();
+    __m256i     acc1 = _mm256_setzero_si256();
+
+    for(int i = 0; i < n_taps; i += 16)
+    {
+        src_mrhf_macc8_avx2(&acc0, piData + i, piCoefs + i);
+        src_mrhf_macc8_avx2(&acc1, piData + i + 8, piCoefs + i + 8);
+    }
+
+    return src_mrhf_hsum_avx2(_mm256_add_epi64(acc0, acc1));
+}
+
+// ===========================================================================
+//
+// Functions implementations
+//
+// ===========================================================================
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_inner_loop_avx2                        //
+// Description:        AVX2 version of src_mrhf_fir_inner_loop_c            //
+// ==================================================================== //
+SRC_MRHF_AVX2 void src_mrhf_fir_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = src_mrhf_dot_avx2(piData, piCoefs, (count >> 3) << 4);
+
+    LSAT30(&lAcc);
+    EXT30(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_os_inner_loop_avx2                        //
+// Description:        AVX2 version of src_mrhf_fir_os_inner_loop_c        //
+// ==================================================================== //
+SRC_MRHF_AVX2 void src_mrhf_fir_os_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count)
+{
+    __m256i     acc0 = _mm256_setzero_si256();
+    __m256i     acc1 = _mm256_setzero_si256();
+    int         iNData = (count >> 2) << 3;
+    __int64     lAcc0, lAcc1;
+
+    for(int i = 0; i < iNData; i += 4)
+    {
+        // 4 data samples, one per 64-bit lane, against 4 even/odd coefficient pairs
+        __m256i     x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(piData + i)));
+        __m256i     c = _mm256_loadu_si256((const __m256i *)(piCoefs + 2 * i));
+
+        acc0 = _mm256_add_epi64(acc0, _mm256_mul_epi32(x, c));
+        acc1 = _mm256_add_epi64(acc1, _mm256_mul_epi32(x, _mm256_srli_epi64(c, 32)));
+    }
+
+    lAcc0 = src_mrhf_hsum_avx2(acc0);
+    lAcc1 = src_mrhf_hsum_avx2(acc1);
+
+    LSAT30(&lAcc0);
+    EXT30(&iData[0], lAcc0);
+    LSAT30(&lAcc1);
+    EXT30(&iData[1], lAcc1);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_adfir_inner_loop_avx2                        //
+// Description:        AVX2 version of src_mrhf_adfir_inner_loop_c            //
+// ==================================================================== //
+SRC_MRHF_AVX2 void src_mrhf_adfir_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = src_mrhf_dot_avx2(piData, piCoefs, (count >> 3) << 4);
+
+    LSAT29(&lAcc);
+    EXT29(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_spline_coeff_gen_inner_loop_avx2            //
+// Description:        AVX2 version of                                        //
+//                    src_mrhf_spline_coeff_gen_inner_loop_c                //
+// ==================================================================== //
+SRC_MRHF_AVX2 void src_mrhf_spline_coeff_gen_inner_loop_avx2(int *piPhase0, int *iH, int* piADCoefs, const int n_taps)
+{
+    int*        piPhase1 = piPhase0 + n_taps;
+    int*        piPhase2 = piPhase1 + n_taps;
+    __m256i     h2 = _mm256_set1_epi32(iH[2]);
+    __m256i     h1 = _mm256_set1_epi32(iH[1]);
+    __m256i     h0 = _mm256_set1_epi32(iH[0]);
+    int         i;
+
+    for(i = 0; i + 8 <= n_taps; i += 8)
+    {
+        __m256i     p0 = _mm256_loadu_si256((const __m256i *)(piPhase0 + i));
+        __m256i     p1 = _mm256_loadu_si256((const __m256i *)(piPhase1 + i));
+        __m256i     p2 = _mm256_loadu_si256((const __m256i *)(piPhase2 + i));
+        __m256i     accE, accO;
+
+        // Even taps
+        accE = _mm256_mul_epi32(h2, p0);
+        accE = _mm256_add_epi64(accE, _mm256_mul_epi32(h1, p1));
+        accE = _mm256_add_epi64(accE, _mm256_mul_epi32(h0, p2));
+
+        // Odd taps
+        accO = _mm256_mul_epi32(h2, _mm256_srli_epi64(p0, 32));
+        accO = _mm256_add_epi64(accO, _mm256_mul_epi32(h1, _mm256_srli_epi64(p1, 32)));
+        accO = _mm256_add_epi64(accO, _mm256_mul_epi32(h0, _mm256_srli_epi64(p2, 32)));
+
+        // Keep bits [63:32] of each result, re-interleaving even and odd taps
+        _mm256_storeu_si256((__m256i *)(piADCoefs + i),
+                            _mm256_blend_epi32(_mm256_srli_epi64(accE, 32), accO, 0xAA));
+    }
+
+    for(; i < n_taps; i++)
+    {
+        __int64 lAcc = 0;
+
+        MACC(&lAcc, iH[2], piPhase0[i]);
+        MACC(&lAcc, iH[1], piPhase1[i]);
+        MACC(&lAcc, iH[0], piPhase2[i]);
+
+        piADCoefs[i] = (int)(lAcc >> 32);
+    }
+}
+
+#endif // !__xcore__ && SRC_MRHF_HAVE_AVX2
@@ -0,0 +1,245 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// Portable C implementations of the multirate_hifi inner loops
+//
+// These are bit-exact equivalents of the XS2 assembler inner loops and are
+// used when lib_src is compiled for a target other than xcore (e.g. a host
+// build for offline processing or CI). On xcore the assembler versions are
+// linked instead and this file compiles to nothing.
+//
+// The src_mrhf_*_inner_loop_asm() entry points select a SIMD version
+// (AVX2 or NEON) when one is available and fall back to scalar C otherwise.
+//
+// ===========================================================================
+// ===========================================================================
+#if !defined(__xcore__)
+
+// ===========================================================================
+//
+// Includes
+//
+// ===========================================================================
+#include "src_mrhf_int_arithmetic.h"
+#include "src_mrhf_fir_inner_loop_asm.h"
+#include "src_mrhf_fir_os_inner_loop_asm.h"
+#include "src_mrhf_adfir_inner_loop_asm.h"
+#include "src_mrhf_spline_coeff_gen_inner_loop_asm.h"
+#include "src_mrhf_inner_loop_c.h"
+
+// ===========================================================================
+//
+// TypeDefs
+//
+// ===========================================================================
+typedef struct _SRCMRHFInnerLoops_t
+{
+    void            (*pfFir)(int *piData, int *piCoefs, int iData[], int count);
+    void            (*pfFirOs)(int *piData, int *piCoefs, int iData[], int count);
+    void            (*pfADFir)(int *piData, int *piCoefs, int iData[], int count);
+    void            (*pfSpline)(int *piPhase0, int *iH, int* piADCoefs, const int n_taps);
+} SRCMRHFInnerLoops_t;
+
+// ===========================================================================
+//
+// Variables
+//
+// ===========================================================================
+
+// Selected implementations. NEON is part of the AArch64 baseline so is chosen at
+// compile time, AVX2 is checked for at load time by src_mrhf_inner_loop_resolve().
+#if SRC_MRHF_HAVE_NEON
+static SRCMRHFInnerLoops_t      sInnerLoops = {
+    src_mrhf_fir_inner_loop_neon,
+    src_mrhf_fir_os_inner_loop_neon,
+    src_mrhf_adfir_inner_loop_neon,
+    src_mrhf_spline_coeff_gen_inner_loop_neon
+};
+#else
+static SRCMRHFInnerLoops_t      sInnerLoops = {
+    src_mrhf_fir_inner_loop_c,
+    src_mrhf_fir_os_inner_loop_c,
+    src_mrhf_adfir_inner_loop_c,
+    src_mrhf_spline_coeff_gen_inner_loop_c
+};
+#endif
+
+// ===========================================================================
+//
+// Functions implementations
+//
+// ===========================================================================
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_inner_loop_c                            //
+// Arguments:        int *piData: Pointer to delay line                    //
+//                    int *piCoefs: Pointer to coefficients                //
+//                    int iData[]: Result (1 value)                        //
+//                    int count: Number of loops (taps / 2)                //
+// Return values:    None                                                //
+// Description:        32x32->64 MACC, saturate and extract bits [62:31]    //
+// ==================================================================== //
+void src_mrhf_fir_inner_loop_c(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = 0;
+    int         iNTaps = (count >> 3) << 4;
+
+    for(int i = 0; i < iNTaps; i++)
+        MACC(&lAcc, piData[i], piCoefs[i]);
+
+    LSAT30(&lAcc);
+    EXT30(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_os_inner_loop_c                        //
+// Arguments:        int *piData: Pointer to delay line                    //
+//                    int *piCoefs: Pointer to coefficients                //
+//                    int iData[]: Result (2 values)                        //
+//                    int count: Number of loops (coefs / 4)                //
+// Return values:    None                                                //
+// Description:        Over-sampler by 2 MACC. Even coefficients produce    //
+//                    iData[0] and odd coefficients produce iData[1].        //
+// ==================================================================== //
+void src_mrhf_fir_os_inner_loop_c(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc0 = 0;
+    __int64     lAcc1 = 0;
+    int         iNData = (count >> 2) << 3;
+
+    for(int i = 0; i < iNData; i++)
+    {
+        MACC(&lAcc0, piData[i], piCoefs[2 * i]);
+        MACC(&lAcc1, piData[i], piCoefs[2 * i + 1]);
+    }
+
+    LSAT30(&lAcc0);
+    EXT30(&iData[0], lAcc0);
+    LSAT30(&lAcc1);
+    EXT30(&iData[1], lAcc1);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_adfir_inner_loop_c                            //
+// Arguments:        int *piData: Pointer to delay line                    //
+//                    int *piCoefs: Pointer to coefficients                //
+//                    int iData[]: Result (1 value)                        //
+//                    int count: Number of loops (taps / 2)                //
+// Return values:    None                                                //
+// Description:        32x32->64 MACC, saturate and extract bits [61:30]    //
+// ==================================================================== //
+void src_mrhf_adfir_inner_loop_c(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = 0;
+    int         iNTaps = (count >> 3) << 4;
+
+    for(int i = 0; i < iNTaps; i++)
+        MACC(&lAcc, piData[i], piCoefs[i]);
+
+    LSAT29(&lAcc);
+    EXT29(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_spline_coeff_gen_inner_loop_c                //
+// Arguments:        int *piPhase0: Pointer to first of 3 adjacent phases//
+//                    int *iH: Spline coefficients                        //
+//                    int *piADCoefs: Output adaptive coefficients        //
+//                    int n_taps: Number of taps per phase                //
+// Return values:    None                                                //
+// Description:        Interpolates the ADFIR coefficients from 3 phases    //
+//                    of the prototype filter, keeping bits [63:32]        //
+// ==================================================================== //
+void src_mrhf_spline_coeff_gen_inner_loop_c(int *piPhase0, int *iH, int* piADCoefs, const int n_taps)
+{
+    int*        piPhase1 = piPhase0 + n_taps;
+    int*        piPhase2 = piPhase1 + n_taps;
+
+    for(int i = 0; i < n_taps; i++)
+    {
+        __int64 lAcc = 0;
+
+        MACC(&lAcc, iH[2], piPhase0[i]);
+        MACC(&lAcc, iH[1], piPhase1[i]);
+        MACC(&lAcc, iH[0], piPhase2[i]);
+
+        piADCoefs[i] = (int)(lAcc >> 32);
+    }
+}
+
+#if SRC_MRHF_HAVE_AVX2
+// ==================================================================== //
+// Function:        src_mrhf_inner_loop_resolve                            //
+// Arguments:        None                                                //
+// Return values:    None                                                //
+// Description:        Selects the AVX2 inner loops if the CPU supports    //
+//                    them. Runs once at load time, before any SRC call.    //
+// ==================================================================== //
+__attribute__((constructor)) static void src_mrhf_inner_loop_resolve(void)
+{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        sInnerLoops.pfFir       = src_mrhf_fir_inner_loop_avx2;
+        sInnerLoops.pfFirOs     = src_mrhf_fir_os_inner_loop_avx2;
+        sInnerLoops.pfADFir     = src_mrhf_adfir_inner_loop_avx2;
+        sInnerLoops.pfSpline    = src_mrhf_spline_coeff_gen_inner_loop_avx2;
+    }
+}
+#endif
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_inner_loop_asm(_odd)                    //
+// Description:        Host version of the FIR inner loop. The alignment    //
+//                    of piData only matters to the assembler version.    //
+// ==================================================================== //
+void src_mrhf_fir_inner_loop_asm(int *piData, int *piCoefs, int iData[], int count)
+{
+    sInnerLoops.pfFir(piData, piCoefs, iData, count);
+}
+
+void src_mrhf_fir_inner_loop_asm_odd(int *piData, int *piCoefs, int iData[], int count)
+{
+    src_mrhf_fir_inner_loop_asm(piData, piCoefs, iData, count);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_os_inner_loop_asm(_odd)                //
+// Description:        Host version of the FIR OS2 inner loop                //
+// ==================================================================== //
+void src_mrhf_fir_os_inner_loop_asm(int *piData, int *piCoefs, int iData[], int count)
+{
+    sInnerLoops.pfFirOs(piData, piCoefs, iData, count);
+}
+
+void src_mrhf_fir_os_inner_loop_asm_odd(int *piData, int *piCoefs, int iData[], int count)
+{
+    src_mrhf_fir_os_inner_loop_asm(piData, piCoefs, iData, count);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_adfir_inner_loop_asm(_odd)                    //
+// Description:        Host version of the ADFIR inner loop                //
+// ==================================================================== //
+void src_mrhf_adfir_inner_loop_asm(int *piData, int *piCoefs, int iData[], int count)
+{
+    sInnerLoops.pfADFir(piData, piCoefs, iData, count);
+}
+
+void src_mrhf_adfir_inner_loop_asm_odd(int *piData, int *piCoefs, int iData[], int count)
+{
+    src_mrhf_adfir_inner_loop_asm(piData, piCoefs, iData, count);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_spline_coeff_gen_inner_loop_asm            //
+// Description:        Host version of the spline coefficient generator    //
+// ==================================================================== //
+void src_mrhf_spline_coeff_gen_inner_loop_asm(int *piPhase0, int *iH, int* piADCoefs, const int n_taps)
+{
+    sInnerLoops.pfSpline(piPhase0, iH, piADCoefs, n_taps);
+}
+
+#endif // !__xcore__
@@ -0,0 +1,60 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// Host (non-xcore) implementations of the multirate_hifi inner loops
+//
+// The public src_mrhf_*_inner_loop_asm() entry points dispatch at runtime to
+// the fastest implementation the CPU supports. All of them are bit-exact with
+// the XS2 assembler versions.
+//
+// ===========================================================================
+// ===========================================================================
+#ifndef _SRC_MRHF_INNER_LOOP_C_H_
+#define _SRC_MRHF_INNER_LOOP_C_H_
+
+#if !defined(__xcore__)
+
+// Set to 0 to build the scalar C inner loops only
+#ifndef SRC_MRHF_HOST_SIMD
+#define SRC_MRHF_HOST_SIMD          1
+#endif
+
+#if SRC_MRHF_HOST_SIMD && defined(__x86_64__) && defined(__GNUC__)
+#define SRC_MRHF_HAVE_AVX2          1
+#else
+#define SRC_MRHF_HAVE_AVX2          0
+#endif
+
+#if SRC_MRHF_HOST_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define SRC_MRHF_HAVE_NEON          1
+#else
+#define SRC_MRHF_HAVE_NEON          0
+#endif
+
+// Scalar C versions, always available
+void src_mrhf_fir_inner_loop_c(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_fir_os_inner_loop_c(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_adfir_inner_loop_c(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_spline_coeff_gen_inner_loop_c(int *piPhase0, int *iH, int* piADCoefs, const int n_taps);
+
+#if SRC_MRHF_HAVE_AVX2
+// x86 AVX2 versions, only called when the CPU reports AVX2 support
+void src_mrhf_fir_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_fir_os_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_adfir_inner_loop_avx2(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_spline_coeff_gen_inner_loop_avx2(int *piPhase0, int *iH, int* piADCoefs, const int n_taps);
+#endif
+
+#if SRC_MRHF_HAVE_NEON
+// Arm NEON versions, NEON is mandatory on AArch64 so these are selected at compile time
+void src_mrhf_fir_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_fir_os_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_adfir_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count);
+void src_mrhf_spline_coeff_gen_inner_loop_neon(int *piPhase0, int *iH, int* piADCoefs, const int n_taps);
+#endif
+
+#endif // !__xcore__
+
+#endif // _SRC_MRHF_INNER_LOOP_C_H_
@@ -0,0 +1,167 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// Arm NEON implementations of the multirate_hifi inner loops
+//
+// VMLAL.S32 accumulates signed 32x32->64 products into 64-bit lanes which
+// wrap exactly as the xcore MACCS accumulator does, so the results are
+// bit-exact with the scalar C and XS2 assembler versions.
+//
+// ===========================================================================
+// ===========================================================================
+#include "src_mrhf_inner_loop_c.h"
+
+#if !defined(__xcore__) && SRC_MRHF_HAVE_NEON
+
+// ===========================================================================
+//
+// Includes
+//
+// ===========================================================================
+#include <arm_neon.h>
+#include "src_mrhf_int_arithmetic.h"
+
+// ===========================================================================
+//
+// Local Functions implementations
+//
+// ===========================================================================
+
+// Sum of the 2 x 64i lanes
+static inline __int64 src_mrhf_hsum_neon(int64x2_t acc)
+{
+    return (__int64)vgetq_lane_s64(acc, 0) + (__int64)vgetq_lane_s64(acc, 1);
+}
+
+// Plain dot product over n_taps (a multiple of 16)
+static inline __int64 src_mrhf_dot_neon(const int *piData, const int *piCoefs, int n_taps)
+{
+    int64x2_t   acc0 = vdupq_n_s64(0);
+    int64x2_t   acc1 = vdupq_n_s64(0);
+
+    for(int i = 0; i < n_taps; i += 8)
+    {
+        int32x4_t   x0 = vld1q_s32(piData + i);
+        int32x4_t   y0 = vld1q_s32(piCoefs + i);
+        int32x4_t   x1 = vld1q_s32(piData + i + 4);
+        int32x4_t   y1 = vld1q_s32(piCoefs + i + 4);
+
+        acc0 = vmlal_s32(acc0, vget_low_s32(x0), vget_low_s32(y0));
+        acc1 = vmlal_s32(acc1, vget_high_s32(x0), vget_high_s32(y0));
+        acc0 = vmlal_s32(acc0, vget_low_s32(x1), vget_low_s32(y1));
+        acc1 = vmlal_s32(acc1, vget_high_s32(x1), vget_high_s32(y1));
+    }
+
+    return src_mrhf_hsum_neon(vaddq_s64(acc0, acc1));
+}
+
+// ===========================================================================
+//
+// Functions implementations
+//
+// ===========================================================================
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_inner_loop_neon                        //
+// Description:        NEON version of src_mrhf_fir_inner_loop_c            //
+// ==================================================================== //
+void src_mrhf_fir_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = src_mrhf_dot_neon(piData, piCoefs, (count >> 3) << 4);
+
+    LSAT30(&lAcc);
+    EXT30(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_fir_os_inner_loop_neon                        //
+// Description:        NEON version of src_mrhf_fir_os_inner_loop_c        //
+// ==================================================================== //
+void src_mrhf_fir_os_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count)
+{
+    int64x2_t   acc0 = vdupq_n_s64(0);
+    int64x2_t   acc1 = vdupq_n_s64(0);
+    int         iNData = (count >> 2) << 3;
+    __int64     lAcc0, lAcc1;
+
+    for(int i = 0; i < iNData; i += 4)
+    {
+        // De-interleave 4 even/odd coefficient pairs
+        int32x4_t   x = vld1q_s32(piData + i);
+        int32x4x2_t c = vld2q_s32(piCoefs + 2 * i);
+
+        acc0 = vmlal_s32(acc0, vget_low_s32(x), vget_low_s32(c.val[0]));
+        acc0 = vmlal_s32(acc0, vget_high_s32(x), vget_high_s32(c.val[0]));
+        acc1 = vmlal_s32(acc1, vget_low_s32(x), vget_low_s32(c.val[1]));
+        acc1 = vmlal_s32(acc1, vget_high_s32(x), vget_high_s32(c.val[1]));
+    }
+
+    lAcc0 = src_mrhf_hsum_neon(acc0);
+    lAcc1 = src_mrhf_hsum_neon(acc1);
+
+    LSAT30(&lAcc0);
+    EXT30(&iData[0], lAcc0);
+    LSAT30(&lAcc1);
+    EXT30(&iData[1], lAcc1);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_adfir_inner_loop_neon                        //
+// Description:        NEON version of src_mrhf_adfir_inner_loop_c            //
+// ==================================================================== //
+void src_mrhf_adfir_inner_loop_neon(int *piData, int *piCoefs, int iData[], int count)
+{
+    __int64     lAcc = src_mrhf_dot_neon(piData, piCoefs, (count >> 3) << 4);
+
+    LSAT29(&lAcc);
+    EXT29(&iData[0], lAcc);
+}
+
+// ==================================================================== //
+// Function:        src_mrhf_spline_coeff_gen_inner_loop_neon            //
+// Description:        NEON version of                                        //
+//                    src_mrhf_spline_coeff_gen_inner_loop_c                //
+// ==================================================================== //
+void src_mrhf_spline_coeff_gen_inner_loop_neon(int *piPhase0, int *iH, int* piADCoefs, const int n_taps)
+{
+    int*        piPhase1 = piPhase0 + n_taps;
+    int*        piPhase2 = piPhase1 + n_taps;
+    int32x2_t   h2 = vdup_n_s32(iH[2]);
+    int32x2_t   h1 = vdup_n_s32(iH[1]);
+    int32x2_t   h0 = vdup_n_s32(iH[0]);
+    int         i;
+
+    for(i = 0; i + 4 <= n_taps; i += 4)
+    {
+        int32x4_t   p0 = vld1q_s32(piPhase0 + i);
+        int32x4_t   p1 = vld1q_s32(piPhase1 + i);
+        int32x4_t   p2 = vld1q_s32(piPhase2 + i);
+        int64x2_t   accL, accH;
+
+        accL = vmull_s32(h2, vget_low_s32(p0));
+        accL = vmlal_s32(accL, h1, vget_low_s32(p1));
+        accL = vmlal_s32(accL, h0, vget_low_s32(p2));
+
+        accH = vmull_s32(h2, vget_high_s32(p0));
+        accH = vmlal_s32(accH, h1, vget_high_s32(p1));
+        accH = vmlal_s32(accH, h0, vget_high_s32(p2));
+
+        // Keep bits [63:32] of each result
+        vst1q_s32(piADCoefs + i, vcombine_s32(vshrn_n_s64(accL, 32), vshrn_n_s64(accH, 32)));
+    }
+
+    for(; i < n_taps; i++)
+    {
+        __int64 lAcc = 0;
+
+        MACC(&lAcc, iH[2], piPhase0[i]);
+        MACC(&lAcc, iH[1], piPhase1[i]);
+        MACC(&lAcc, iH[0], piPhase2[i]);
+
+        piADCoefs[i] = (int)(lAcc >> 32);
+    }
+}
+
+#endif // !__xcore__ && SRC_MRHF_HAVE_NEON
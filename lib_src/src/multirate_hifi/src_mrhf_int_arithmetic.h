@@ -9,7 +9,12 @@
     //
     // ===========================================================================
 
+#if defined(__xcore__)
 #define __int64         long long
+#else
+#include <stdint.h>
+#define __int64         int64_t     // Match __int64_t so host builds see a single 64-bit type
+#endif
 
     // ===========================================================================
     //
@@ -23,8 +23,6 @@
 
 // Integer arithmetic include
 #include "src_mrhf_int_arithmetic.h"
-// XMOS built in functions
-#include <xs1.h>
 // SSRC include
 #include "src.h"
 
@@ -393,7 +391,7 @@ SSRCReturnCodes_t                SSRC_proc_F1_F2(ssrc_ctrl_t* pssrc_ctrl)
     }
 
     // F1 is enabled, so call F1
-    __attribute__((fptrgroup("MRHF_G1")))
+    MRHF_G1_FPTRGROUP
     FIRReturnCodes_t ret = pssrc_ctrl->sFIRF1Ctrl.pvProc((int *)&pssrc_ctrl->sFIRF1Ctrl);
     if(ret != FIR_NO_ERROR)
         return SSRC_ERROR;
@@ -403,7 +401,7 @@ SSRCReturnCodes_t                SSRC_proc_F1_F2(ssrc_ctrl_t* pssrc_ctrl)
     if(pssrc_ctrl->sFIRF2Ctrl.eEnable == FIR_ON)
     {
         // F2 is enabled, so call F2
-        __attribute__((fptrgroup("MRHF_G1")))
+        MRHF_G1_FPTRGROUP
         FIRReturnCodes_t ret = pssrc_ctrl->sFIRF2Ctrl.pvProc((int *)&pssrc_ctrl->sFIRF2Ctrl);
         if(ret != FIR_NO_ERROR)
             return SSRC_ERROR;
@@ -104,9 +104,9 @@
         typedef struct _SSRCState
         {
             long long                               pad_to_64b_alignment;
-            int                                        iDelayFIRLong[2 * FILTER_DEFS_FIR_MAX_TAPS_LONG];        // Doubled length for circular buffer simulation
-            int                                        iDelayFIRShort[2 * FILTER_DEFS_FIR_MAX_TAPS_SHORT];        // Doubled length for circular buffer simulation
-            int                                        iDelayPPFIR[2 * FILTER_DEFS_PPFIR_PHASE_MAX_TAPS];        // Doubled length for circular buffer simulation
+            int                                        iDelayFIRLong[FIR_DELAY_LENGTH(FILTER_DEFS_FIR_MAX_TAPS_LONG)];    // Filter window plus slack
+            int                                        iDelayFIRShort[FIR_DELAY_LENGTH(FILTER_DEFS_FIR_MAX_TAPS_SHORT)];    // Filter window plus slack
+            int                                        iDelayPPFIR[FIR_DELAY_LENGTH(FILTER_DEFS_PPFIR_PHASE_MAX_TAPS)];    // Filter window plus slack
             unsigned int                            uiRndSeed;                                              // Dither random seeds current values
 
         } ssrc_state_t;
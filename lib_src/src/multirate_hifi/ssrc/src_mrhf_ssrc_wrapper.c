@@ -5,8 +5,13 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#if defined(__xcore__)
 #include <timer.h>
 #include "debug_print.h"
+#else
+#define debug_printf            printf
+#define delay_milliseconds(ms)
+#endif
 
 // SSRC includes
 #include "src.h"
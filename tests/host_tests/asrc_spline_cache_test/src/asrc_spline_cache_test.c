@@ -0,0 +1,120 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host check of the ASRC spline coefficient cache. For every rate pair and
+// the fs deviations of the golden tests, the same two tone input goes through
+// an instance with the cache, set up by asrc_init_arena(), and one without,
+// set up by asrc_init(). Every output sample must be the same. The cache
+// must only be looked up for an integral time step, so never with an fs
+// deviation, and must serve nearly every lookup for rates of the same family,
+// such as 48 to 192 kHz, at the nominal ratio.
+// asrc_init() must disable the cache without reading the pointer it was
+// given. Exits non zero on a failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define N_CHANNELS          2
+#define N_IN_SAMPLES        4
+#define N_OUT_IN_RATIO_MAX  5       // 44.1 to 192 kHz is the worst case
+#define N_BLOCKS            1024
+
+#define ASRC_N_CHANNELS     N_CHANNELS
+
+#include "src.h"
+
+static const int sample_rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+static const double fs_deviations[] = {1.000000, 0.990099, 1.009999};
+
+static int in_buff[N_IN_SAMPLES * N_CHANNELS];
+static int out_cache[N_IN_SAMPLES * N_OUT_IN_RATIO_MAX * N_CHANNELS];
+static int out_ref[N_IN_SAMPLES * N_OUT_IN_RATIO_MAX * N_CHANNELS];
+
+// With the cache, from the arena
+static long long asrc_arena[ASRC_ARENA_BYTES(N_CHANNELS, N_IN_SAMPLES) / sizeof(long long) + 1];
+static asrc_ctrl_t asrc_ctrl_cache[N_CHANNELS];
+
+// Without, as mrhf_golden_test
+static asrc_state_t asrc_state[N_CHANNELS];
+static int asrc_stack[N_CHANNELS][ASRC_STACK_LENGTH_MULT * N_IN_SAMPLES];
+static asrc_ctrl_t asrc_ctrl_ref[N_CHANNELS];
+static asrc_adfir_coefs_t asrc_adfir_coefs;
+
+static int run_config(int in_fs, int out_fs, double fs_deviation) {
+    uint64_t fs_ratio;
+    unsigned n_out = 0;
+    int errors = 0;
+
+    asrc_init_arena(in_fs, out_fs, asrc_ctrl_cache, N_CHANNELS, N_IN_SAMPLES, OFF, asrc_arena, sizeof(asrc_arena));
+
+    memset(asrc_ctrl_ref, 0, sizeof(asrc_ctrl_ref));
+    for(int ch = 0; ch < N_CHANNELS; ch++) {
+        asrc_ctrl_ref[ch].psState   = &asrc_state[ch];
+        asrc_ctrl_ref[ch].piStack   = asrc_stack[ch];
+        asrc_ctrl_ref[ch].piADCoefs = asrc_adfir_coefs.iASRCADFIRCoefs;
+    }
+    asrc_ctrl_ref[0].psSplineCache = (asrc_spline_cache_t *)(uintptr_t)1; // Never set up, must not be read
+    asrc_init(in_fs, out_fs, asrc_ctrl_ref, N_CHANNELS, N_IN_SAMPLES, OFF);
+    if (asrc_ctrl_ref[0].psSplineCache != NULL) {
+        errors++;
+    }
+
+    // As mrhf_golden_test, including the truncation through double
+    fs_ratio = (uint64_t)(((double)sample_rates[in_fs] / sample_rates[out_fs]) * ((uint64_t)1 << (28 + 32)));
+    fs_ratio = (uint64_t)((double)fs_ratio * fs_deviation);
+
+    for(int block = 0; block < N_BLOCKS; block++) {
+        for(int i = 0; i < N_IN_SAMPLES; i++) {
+            double t = (double)(block * N_IN_SAMPLES + i) / sample_rates[in_fs];
+            in_buff[i * N_CHANNELS + 0] = (int)(0x40000000 * sin(2 * M_PI * 1000 * t));
+            in_buff[i * N_CHANNELS + 1] = (int)(0x20000000 * (sin(2 * M_PI * 10000 * t) + sin(2 * M_PI * 11000 * t)));
+        }
+        unsigned n_cache = asrc_process(in_buff, out_cache, fs_ratio, asrc_ctrl_cache);
+        unsigned n_ref = asrc_process(in_buff, out_ref, fs_ratio, asrc_ctrl_ref);
+        if (n_cache != n_ref || memcmp(out_cache, out_ref, n_ref * N_CHANNELS * sizeof(int)) != 0) {
+            printf("block %d differs\n", block);
+            errors++;
+            break;
+        }
+        n_out += n_ref;
+    }
+
+    asrc_spline_cache_t *cache = asrc_ctrl_cache[0].psSplineCache;
+    if (fs_deviation != 1.0 && cache->uiNLookups != 0) {
+        errors++;   // Not an integral time step
+    }
+    // Rates of the same family at the nominal ratio step by whole phases, after the first few
+    // lookups every one must hit
+    if (fs_deviation == 1.0 && (in_fs & 1) == (out_fs & 1) &&
+        (cache->uiNLookups == 0 || cache->uiNHits + ASRC_SPLINE_CACHE_N_ENTRIES < cache->uiNLookups)) {
+        errors++;
+    }
+    if (cache->uiNHits > cache->uiNLookups) {
+        errors++;
+    }
+    printf("%d to %d (%f): %u samples, %u lookups, %u hits%s\n", sample_rates[in_fs], sample_rates[out_fs], fs_deviation,
+           n_out, cache->uiNLookups, cache->uiNHits, errors ? " FAIL" : "");
+    return errors;
+}
+
+int main(void) {
+    int errors = 0;
+
+    for(int in_fs = FS_CODE_44; in_fs <= FS_CODE_192; in_fs++) {
+        for(int out_fs = FS_CODE_44; out_fs <= FS_CODE_192; out_fs++) {
+            for(int d = 0; d < sizeof(fs_deviations) / sizeof(fs_deviations[0]); d++) {
+                errors += run_config(in_fs, out_fs, fs_deviations[d]);
+            }
+        }
+    }
+
+    if (errors) {
+        printf("FAIL: %d errors\n", errors);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host check of calculate_job_share(), the asrc_task scheduler. Every
+// schedule must cover each channel once, in order, with no job over the
+// channels its ASRC state has room for, and schedule[0] the largest. Some
+// known cases also check the split itself, including with
+// ASRC_TASK_THREAD_MHZ set, where a cheap rate pair must not pack more
+// channels into a job than it has room for. Exits non zero on a failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "src.h"
+#include "asrc_task_schedule.h"
+
+#define MAX_THREADS         (6)
+#define MAX_CHANNELS_TOTAL  (8)
+
+typedef struct {
+    int channels;
+    int threads;                            // MAX_ASRC_THREADS
+    int channels_total;                     // MAX_ASRC_CHANNELS_TOTAL
+    int thread_mhz;                         // ASRC_TASK_THREAD_MHZ
+    int in_fs_code;
+    int out_fs_code;
+    int num_jobs;                           // Expected
+    int num_channels[MAX_THREADS];
+} schedule_case_t;
+
+static const schedule_case_t cases[] = {
+    // All threads when the thread MHz is not set
+    {8, 4, 8,   0, FS_CODE_44,  FS_CODE_48,  4, {2, 2, 2, 2}},
+    {5, 4, 5,   0, FS_CODE_44,  FS_CODE_48,  3, {2, 2, 1}},
+    {7, 4, 8,   0, FS_CODE_48,  FS_CODE_48,  4, {2, 2, 2, 1}},
+    // Four channels of 44.1 to 48 kHz fit in 120 MHz, but a job only has room for 2
+    {8, 4, 8, 120, FS_CODE_44,  FS_CODE_48,  4, {2, 2, 2, 2}},
+    {5, 4, 5, 120, FS_CODE_44,  FS_CODE_44,  3, {2, 2, 1}},
+    // Fewer channels than the application is sized for leave threads idle
+    {2, 4, 8, 120, FS_CODE_44,  FS_CODE_44,  1, {2}},
+    {4, 2, 8, 120, FS_CODE_44,  FS_CODE_44,  1, {4}},
+    // Too costly for any split, so all threads
+    {8, 4, 8, 120, FS_CODE_192, FS_CODE_192, 4, {2, 2, 2, 2}},
+    {0, 4, 8, 120, FS_CODE_48,  FS_CODE_48,  0, {0}},
+};
+
+static int max_channels_per_job(int channels_total, int threads) {
+    return (channels_total + threads - 1) / threads; // As SRC_MAX_SRC_CHANNELS_PER_INSTANCE
+}
+
+static int check_schedule(int channels, int threads, int max_per_job, int num_jobs, const schedule_info_t *schedule) {
+    int next = 0;
+
+    if (num_jobs > threads || (channels > 0 && num_jobs < 1)) {
+        return 1;
+    }
+    for(int i = 0; i < num_jobs; i++) {
+        if (schedule[i].channel_start_idx != next || schedule[i].num_channels < 1 ||
+            schedule[i].num_channels > max_per_job || schedule[i].num_channels > schedule[0].num_channels) {
+            return 1;
+        }
+        next += schedule[i].num_channels;
+    }
+    return next != channels;
+}
+
+int main(void) {
+    schedule_info_t schedule[MAX_THREADS];
+    int errors = 0;
+
+    for(int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const schedule_case_t *c = &cases[i];
+        int max_per_job = max_channels_per_job(c->channels_total, c->threads);
+        int num_jobs = calculate_job_share(c->channels, c->in_fs_code, c->out_fs_code, c->threads,
+                                           max_per_job, c->thread_mhz, schedule);
+        int error = num_jobs != c->num_jobs ||
+                    check_schedule(c->channels, c->threads, max_per_job, num_jobs, schedule);
+        for(int j = 0; j < num_jobs && !error; j++) {
+            error = schedule[j].num_channels != c->num_channels[j];
+        }
+        printf("%d channels on %d threads at %d MHz: %d jobs%s\n", c->channels, c->threads, c->thread_mhz,
+               num_jobs, error ? " FAIL" : "");
+        errors += error;
+    }
+
+    // Every rate pair, channel count and thread count
+    static const int thread_mhz[] = {0, 60, 120, 1000};
+    for(int threads = 1; threads <= MAX_THREADS; threads++) {
+        int max_per_job = max_channels_per_job(MAX_CHANNELS_TOTAL, threads);
+        for(int channels = 1; channels <= MAX_CHANNELS_TOTAL; channels++) {
+            for(int m = 0; m < sizeof(thread_mhz) / sizeof(thread_mhz[0]); m++) {
+                for(int in = FS_CODE_44; in <= FS_CODE_192; in++) {
+                    for(int out = FS_CODE_44; out <= FS_CODE_192; out++) {
+                        int num_jobs = calculate_job_share(channels, in, out, threads, max_per_job, thread_mhz[m], schedule);
+                        if (check_schedule(channels, threads, max_per_job, num_jobs, schedule)) {
+                            printf("%d channels on %d threads at %d MHz, fs codes %d to %d: FAIL\n",
+                                   channels, threads, thread_mhz[m], in, out);
+                            errors++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (errors) {
+        printf("FAIL: %d errors\n", errors);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
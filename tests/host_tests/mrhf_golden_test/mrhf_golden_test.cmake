@@ -0,0 +1,55 @@
+# Runs the golden model and mrhf_golden_test over every rate pair, and for the
+# ASRC every fs deviation, with the same signals, length and deviations as
+# tests/sim_tests/test_mrhf.py. Fails on the first rate pair that differs.
+#
+# cmake -DSRC_TYPE=<ssrc|asrc> -DMODEL=<model> -DDUT=<mrhf_golden_test>
+#       -DINPUT_DIR=<tests/utils/src_input> -DOUTPUT_DIR=<dir> -P mrhf_golden_test.cmake
+
+set(NUM_SAMPLES_TO_PROCESS 256)
+set(SR_NAMES 44 48 88 96 176 192)
+if(SRC_TYPE STREQUAL "asrc")
+    set(FS_DEVIATIONS 1.000000 0.990099 1.009999)
+else()
+    set(FS_DEVIATIONS 1.0)
+endif()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+set(PAIRS 0)
+foreach(IN_FS RANGE 5)
+    list(GET SR_NAMES ${IN_FS} IN_NAME)
+    set(INPUT_0 ${INPUT_DIR}/s1k_0dB_${IN_NAME}.dat)
+    set(INPUT_1 ${INPUT_DIR}/im10k11k_m6dB_${IN_NAME}.dat)
+    foreach(OUT_FS RANGE 5)
+        list(GET SR_NAMES ${OUT_FS} OUT_NAME)
+        foreach(FS_DEVIATION ${FS_DEVIATIONS})
+            set(GOLDEN_0 ${OUTPUT_DIR}/s1k_0dB_${IN_NAME}_${OUT_NAME}_${FS_DEVIATION}.golden)
+            set(GOLDEN_1 ${OUTPUT_DIR}/im10k11k_m6dB_${IN_NAME}_${OUT_NAME}_${FS_DEVIATION}.golden)
+            set(ARGS -i${INPUT_0} -j${INPUT_1} -o${GOLDEN_0} -p${GOLDEN_1}
+                     -k${IN_FS} -q${OUT_FS} -l${NUM_SAMPLES_TO_PROCESS})
+            if(SRC_TYPE STREQUAL "asrc")
+                list(APPEND ARGS -e${FS_DEVIATION})
+            endif()
+
+            # The model waits for a key press before it exits, and reports errors on stdout
+            execute_process(COMMAND ${MODEL} ${ARGS} -d0 -n4
+                            INPUT_FILE /dev/null
+                            OUTPUT_VARIABLE MODEL_OUTPUT
+                            RESULT_VARIABLE MODEL_RESULT)
+            if(NOT MODEL_RESULT EQUAL 0 OR MODEL_OUTPUT MATCHES "ERROR")
+                message(FATAL_ERROR "${MODEL} ${ARGS} failed:\n${MODEL_OUTPUT}")
+            endif()
+
+            execute_process(COMMAND ${DUT} -t${SRC_TYPE} ${ARGS}
+                            OUTPUT_VARIABLE DUT_OUTPUT
+                            ERROR_VARIABLE DUT_OUTPUT
+                            RESULT_VARIABLE DUT_RESULT)
+            if(NOT DUT_RESULT EQUAL 0)
+                message(FATAL_ERROR "${SRC_TYPE} ${IN_NAME}->${OUT_NAME} (${FS_DEVIATION}) differs from the model:\n${DUT_OUTPUT}")
+            endif()
+            math(EXPR PAIRS "${PAIRS} + 1")
+        endforeach()
+    endforeach()
+endforeach()
+
+message(STATUS "${SRC_TYPE}: ${PAIRS} configurations bit-exact with the model")
@@ -0,0 +1,213 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// Host check of the multirate_hifi SSRC and ASRC against the golden output
+//
+// Runs the two input files through the lib_src host build, the same way as
+// the sim_tests ssrc_test and asrc_test DUTs (two channels, blocks of four
+// samples, no dither), and compares every output sample with the golden
+// files written by the C model for the same arguments. Exits non zero on
+// the first difference, so the portable C, AVX2 and NEON inner loops can
+// each be checked to be bit-exact without xsim.
+//
+// Usage: mrhf_golden_test -t<ssrc|asrc> -i<in ch0> -j<in ch1> -o<golden ch0>
+//                         -p<golden ch1> -k<in_fs_code> -q<out_fs_code>
+//                         -l<in_samples> [-e<fs_deviation>]
+//
+// ===========================================================================
+// ===========================================================================
+
+// ===========================================================================
+//
+// Includes
+//
+// ===========================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+//General SRC configuration defines, as the model
+#define     GOLDEN_N_CHANNELS                2  //One stereo pair
+#define     GOLDEN_N_IN_SAMPLES              4  //Input samples per channel per call, the model's -n4
+#define     GOLDEN_N_OUT_IN_RATIO_MAX        5  //Max ratio between samples out:in per processing step (44.1->192 is worst case)
+
+#define     SSRC_N_CHANNELS                  GOLDEN_N_CHANNELS
+#define     SSRC_N_IN_SAMPLES                GOLDEN_N_IN_SAMPLES
+#define     ASRC_N_CHANNELS                  GOLDEN_N_CHANNELS
+
+#include "src.h"
+
+// ===========================================================================
+//
+// Variables
+//
+// ===========================================================================
+
+const int sample_rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+
+static int          in_buff[GOLDEN_N_IN_SAMPLES * GOLDEN_N_CHANNELS];
+static int          out_buff[GOLDEN_N_IN_SAMPLES * GOLDEN_N_OUT_IN_RATIO_MAX * GOLDEN_N_CHANNELS];
+
+static ssrc_state_t         ssrc_state[GOLDEN_N_CHANNELS];
+static int                  ssrc_stack[GOLDEN_N_CHANNELS][SSRC_STACK_LENGTH_MULT * GOLDEN_N_IN_SAMPLES];
+static ssrc_ctrl_t          ssrc_ctrl[GOLDEN_N_CHANNELS];
+
+static asrc_state_t         asrc_state[GOLDEN_N_CHANNELS];
+static int                  asrc_stack[GOLDEN_N_CHANNELS][ASRC_STACK_LENGTH_MULT * GOLDEN_N_IN_SAMPLES];
+static asrc_ctrl_t          asrc_ctrl[GOLDEN_N_CHANNELS];
+static asrc_adfir_coefs_t   asrc_adfir_coefs;
+
+// ===========================================================================
+//
+// Local functions
+//
+// ===========================================================================
+
+static FILE* golden_open(const char* pzName)
+{
+    FILE*   f = fopen(pzName, "rt");
+
+    if(f == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", pzName);
+        exit(1);
+    }
+    return f;
+}
+
+// ===========================================================================
+//
+// Main
+//
+// ===========================================================================
+
+int main(int argc, char** argv)
+{
+    const char* pzType = NULL;
+    const char* pzIn[GOLDEN_N_CHANNELS] = {NULL, NULL};
+    const char* pzGolden[GOLDEN_N_CHANNELS] = {NULL, NULL};
+    int         iInFs = -1;
+    int         iOutFs = -1;
+    unsigned    uiNInSamples = 0;
+    double      fFsRatioDeviation = 1.0;
+    FILE*       InFile[GOLDEN_N_CHANNELS];
+    FILE*       GoldenFile[GOLDEN_N_CHANNELS];
+    unsigned    uiNOut = 0;
+    int         iAsrc;
+    uint64_t    ulFsRatio = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        char*   pzArg = argv[i] + 2;
+
+        if(argv[i][0] != '-')
+        {
+            fprintf(stderr, "Usage: %s -t<ssrc|asrc> -i<in0> -j<in1> -o<golden0> -p<golden1> -k<in_fs> -q<out_fs> -l<in_samples> [-e<fs_deviation>]\n", argv[0]);
+            return 1;
+        }
+        switch(argv[i][1])
+        {
+            case 't': pzType            = pzArg; break;
+            case 'i': pzIn[0]           = pzArg; break;
+            case 'j': pzIn[1]           = pzArg; break;
+            case 'o': pzGolden[0]       = pzArg; break;
+            case 'p': pzGolden[1]       = pzArg; break;
+            case 'k': iInFs             = atoi(pzArg); break;
+            case 'q': iOutFs            = atoi(pzArg); break;
+            case 'l': uiNInSamples      = atoi(pzArg); break;
+            case 'e': fFsRatioDeviation = atof(pzArg); break;
+            default:
+                fprintf(stderr, "Unknown option %s\n", argv[i]);
+                return 1;
+        }
+    }
+    if((pzType == NULL) || (pzIn[1] == NULL) || (pzGolden[1] == NULL) ||
+        (iInFs < 0) || (iInFs > 5) || (iOutFs < 0) || (iOutFs > 5) || (uiNInSamples < GOLDEN_N_IN_SAMPLES))
+    {
+        fprintf(stderr, "Missing or bad arguments\n");
+        return 1;
+    }
+    iAsrc = (strcmp(pzType, "asrc") == 0);
+
+    for(unsigned ui = 0; ui < GOLDEN_N_CHANNELS; ui++)
+    {
+        InFile[ui]      = golden_open(pzIn[ui]);
+        GoldenFile[ui]  = golden_open(pzGolden[ui]);
+    }
+
+    if(iAsrc)
+    {
+        for(unsigned ui = 0; ui < GOLDEN_N_CHANNELS; ui++)
+        {
+            asrc_ctrl[ui].psState   = &asrc_state[ui];
+            asrc_ctrl[ui].piStack   = asrc_stack[ui];
+            asrc_ctrl[ui].piADCoefs = asrc_adfir_coefs.iASRCADFIRCoefs;
+        }
+        asrc_init(iInFs, iOutFs, asrc_ctrl, GOLDEN_N_CHANNELS, GOLDEN_N_IN_SAMPLES, OFF);
+        // Exactly as the asrc_test DUT and the model, including the truncation through double
+        ulFsRatio = (uint64_t)(((double)sample_rates[iInFs] / sample_rates[iOutFs]) * ((uint64_t)1 << (28 + 32)));
+        ulFsRatio = (uint64_t)((double)ulFsRatio * fFsRatioDeviation);
+    }
+    else
+    {
+        for(unsigned ui = 0; ui < GOLDEN_N_CHANNELS; ui++)
+        {
+            ssrc_ctrl[ui].psState   = &ssrc_state[ui];
+            ssrc_ctrl[ui].piStack   = ssrc_stack[ui];
+        }
+        ssrc_init(iInFs, iOutFs, ssrc_ctrl, GOLDEN_N_CHANNELS, GOLDEN_N_IN_SAMPLES, OFF);
+    }
+
+    // The model zero pads an input file shorter than uiNInSamples
+    for(unsigned uiN = 0; uiN + GOLDEN_N_IN_SAMPLES <= uiNInSamples; uiN += GOLDEN_N_IN_SAMPLES)
+    {
+        unsigned    n;
+
+        for(unsigned ui = 0; ui < GOLDEN_N_IN_SAMPLES * GOLDEN_N_CHANNELS; ui++)
+        {
+            if(fscanf(InFile[ui % GOLDEN_N_CHANNELS], "%i\n", &in_buff[ui]) != 1)
+                in_buff[ui] = 0;
+        }
+
+        if(iAsrc)
+            n = asrc_process(in_buff, out_buff, ulFsRatio, asrc_ctrl);
+        else
+            n = ssrc_process(in_buff, out_buff, ssrc_ctrl);
+
+        for(unsigned ui = 0; ui < n * GOLDEN_N_CHANNELS; ui++)
+        {
+            int     iGolden;
+
+            if(fscanf(GoldenFile[ui % GOLDEN_N_CHANNELS], "%i\n", &iGolden) != 1)
+            {
+                printf("FAIL: more output than the golden file at sample %u\n", uiNOut + ui / GOLDEN_N_CHANNELS);
+                return 1;
+            }
+            if(out_buff[ui] != iGolden)
+            {
+                printf("FAIL: channel %u sample %u is %d, golden %d\n", ui % GOLDEN_N_CHANNELS,
+                        uiNOut + ui / GOLDEN_N_CHANNELS, out_buff[ui], iGolden);
+                return 1;
+            }
+        }
+        uiNOut += n;
+    }
+
+    for(unsigned ui = 0; ui < GOLDEN_N_CHANNELS; ui++)
+    {
+        int     iGolden;
+
+        if(fscanf(GoldenFile[ui], "%i\n", &iGolden) == 1)
+        {
+            printf("FAIL: less output than the golden file, %u samples\n", uiNOut);
+            return 1;
+        }
+        fclose(InFile[ui]);
+        fclose(GoldenFile[ui]);
+    }
+    printf("PASS: %s %d->%d, %u samples out\n", pzType, sample_rates[iInFs], sample_rates[iOutFs], uiNOut);
+    return 0;
+}
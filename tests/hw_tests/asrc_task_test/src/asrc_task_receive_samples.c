@@ -5,7 +5,8 @@
 
 ASRC_TASK_ISR_CALLBACK_ATTR
 unsigned receive_asrc_input_samples(chanend_t c_producer, asrc_in_out_t *asrc_io, unsigned *new_input_rate){
-    static unsigned asrc_in_counter = 0;
+    // Kept per stream as this may be called for several streams
+    unsigned asrc_in_counter = asrc_io->input_sample_counter;
 
     // Receive stream info from producer
     *new_input_rate = chanend_in_word(c_producer);
@@ -19,9 +20,10 @@ unsigned receive_asrc_input_samples(chanend_t c_producer, asrc_in_out_t *asrc_io
     }
 
     // Keep track of frame block to ASRC task
-    if(++asrc_in_counter == SRC_N_IN_SAMPLES){
+    if(++asrc_in_counter >= asrc_io->input_block_size){
         asrc_in_counter = 0;
     }
+    asrc_io->input_sample_counter = asrc_in_counter;
 
     return asrc_in_counter;
 }
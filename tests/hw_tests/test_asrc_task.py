@@ -100,7 +100,7 @@ def build_cmd_list_expected_f(input_srs, output_srs, chans, delay_ms, input_freq
 @pytest.fixture(scope="module")
 def build_xe():
     print("Building DUT")
-    xe = build_firmware_xcommon_cmake(Path(__file__).parent / "asrc_task_test")
+    xe = build_firmware_xcommon_cmake(Path(__file__).parent / "asrc_task_test", config="DEFAULT")
     return xe
 
 
@@ -111,8 +111,7 @@ def test_asrc_task_freq_matrix(build_xe):
     It does a full matrix of the input and output frequencies.
     """
     cmd_list, expected_freqs = build_cmd_list_expected_f(SR_LIST, SR_LIST, 4, 100)
-    xe = Path(__file__).parent / "asrc_task_test" / "bin" / "asrc_task_test.xe"
-    output = run_dut(xe, cmd_list, timeout=60)
+    output = run_dut(build_xe, cmd_list, timeout=60)
     vcd2wav("trace.vcd", 0, 1, 44100)
     assert analyse_wav(expected_freqs)
 
@@ -198,30 +197,116 @@ def test_asrc_task_longish_run(build_xe):
     vcd2wav("trace.vcd", 0, 1, 48000)
     analyse_thd("ch0-1-48000.wav")
 
-def analyse_freq_multi_tone(wav_file):
+def analyse_freq_multi_tone(wav_file, n_chans=8, harmonics=None):
+    """ Channel ch must carry harmonics[ch] of the base tone, ch + 1 by default """
+    if harmonics is None:
+        harmonics = [ch + 1 for ch in range(n_chans)]
     sample_rate, data = wavfile.read(wav_file)
     start_chop_s = 0.02
 
-    for ch in range(8):
+    for ch in range(n_chans):
         ch_data = data[:,ch]
         ch_data = (ch_data[int(sample_rate*start_chop_s):] / ((1<<31) - 1)).astype(np.float64)
         thd, freq = THDN_and_freq(ch_data, sample_rate)
 
-        expected_freq = (44100 / 44) * sample_rate / 44100 * (ch + 1)
+        expected_freq = (44100 / 44) * sample_rate / 44100 * harmonics[ch]
         print(F"THD: {thd:.2f}, freq: {freq:.4f}, expected_freq: {expected_freq:.4f}")
 
         assert np.isclose(freq, expected_freq, rtol = 0.001) # Short test and sketchy sine for ch > 0 so larger RTOL
 
-def test_asrc_task_channel_mapping(build_xe):
+# 8 channels split evenly over the 4 threads, 5 (2 + 2 + 1) and 7 (2 + 2 + 2 + 1) do not
+@pytest.mark.parametrize("n_chans", [8, 5, 7])
+def test_asrc_task_channel_mapping(build_xe, n_chans):
     """
     This runs a short test at a multiple frequencies and checks output channels have correct tones
     """
     test_len_s = 1
     test_sr = 44100
-    cmd_list = [[test_sr, 8, test_sr, test_len_s * 1000]]
+    cmd_list = [[test_sr, n_chans, test_sr, test_len_s * 1000]]
     output = run_dut(build_xe, cmd_list, multi_tone=True, timeout=60)
-    vcd2wav("trace.vcd", 0, 8, test_sr)
-    analyse_freq_multi_tone("ch0-8-44100.wav")
+    parse_output_for_changes(output, cmd_list)
+    vcd2wav("trace.vcd", 0, n_chans, test_sr)
+    analyse_freq_multi_tone(f"ch0-{n_chans}-{test_sr}.wav", n_chans)
+
+# PERSISTENT keeps the workers running between rate changes (ASRC_TASK_PERSISTENT_WORKERS), MULTI_STREAM
+# runs a second stream through asrc_task_multi() with its tones in reverse on probes 8 onwards
+@pytest.mark.parametrize("config", ["PERSISTENT", "MULTI_STREAM"])
+@pytest.mark.parametrize("n_chans", [8, 5, 7])
+def test_asrc_task_channel_mapping_config(config, n_chans):
+    """
+    As test_asrc_task_channel_mapping for the builds that change how the channels reach the worker threads
+    """
+    xe = build_firmware_xcommon_cmake(Path(__file__).parent / "asrc_task_test", config=config)
+    test_len_s = 1
+    test_sr = 44100
+    cmd_list = [[test_sr, n_chans, test_sr, test_len_s * 1000]]
+    output = run_dut(xe, cmd_list, multi_tone=True, timeout=60)
+    parse_output_for_changes(output, cmd_list)
+    vcd2wav("trace.vcd", 0, n_chans, test_sr)
+    analyse_freq_multi_tone(f"ch0-{n_chans}-{test_sr}.wav", n_chans)
+    if config == "MULTI_STREAM":
+        assert len(re.findall(r'FIFO init channels', output)) == 2
+        vcd2wav("trace.vcd", 8, 8 + n_chans, test_sr)
+        analyse_freq_multi_tone(f"ch8-{8 + n_chans}-{test_sr}.wav", n_chans, [n_chans - ch for ch in range(n_chans)])
+
+# ASRC total filter delay in ms for blocks of four, from the latency table in the documentation
+FILTER_DELAY_MS = {(44100, 48000): 0.899, (96000, 48000): 0.833}
+SILENCE_THRESHOLD = 0.01 * ((1<<31) - 1)   # 1% of full scale
+MIN_SILENT_SAMPLES = 4                      # The tone never stays this close to zero for this long
+OUTAGE_MARGIN_MS = 0.25                     # For the block the change is seen in and the filter transient
+
+def find_silent_runs(wav_file, skip_ms):
+    """ Returns the lengths of the runs of silence skip_ms after the first sound """
+    sample_rate, data = wavfile.read(wav_file)
+    silent = np.abs(data.astype(np.float64)) < SILENCE_THRESHOLD
+    start = np.argmax(~silent) + int(sample_rate * skip_ms / 1000)
+    runs = []
+    run = 0
+    for s in silent[start:]:
+        if s:
+            run += 1
+        else:
+            if run >= MIN_SILENT_SAMPLES:
+                runs.append(run)
+            run = 0
+    return sample_rate, runs
+
+def test_asrc_task_fast_reconfigure():
+    """
+    Changes the input rate alone with ASRC_TASK_FAST_RECONFIGURE set. The FIFO must be kept, so no re-init,
+    reset, underflow or overflow, and each change must cut the output to silence for no longer than the filter
+    delay of the new rate pair, as documented.
+    """
+    print("Building DUT")
+    xe = build_firmware_xcommon_cmake(Path(__file__).parent / "asrc_task_test", config="FAST_RECONFIGURE")
+    cmd_list = [
+                [48000, 2, 48000, 1000],
+                [44100, 2, 48000, 500],
+                [96000, 2, 48000, 500],
+                ]
+    output = run_dut(xe, cmd_list, timeout=60)
+
+    assert len(re.findall(r'FIFO init channels', output)) == 1
+
+    reconfigures = re.findall(r'Fast reconfigure ticks: (\d+) of (\d+)', output)
+    assert len(reconfigures) == len(cmd_list) - 1
+    for ticks, limit in reconfigures:
+        print(f"Fast reconfigure ticks: {ticks} of {limit}")
+        assert int(ticks) < int(limit)
+
+    # From when the first command has settled the counts must not change
+    stats = re.findall(r'FIFO stats: resets (\d+) underflows (\d+) overflows (\d+)', output)
+    assert len(stats) == len(cmd_list)
+    assert all(s == stats[0] for s in stats)
+
+    vcd2wav("trace.vcd", 0, 1, 48000)
+    sample_rate, runs = find_silent_runs("ch0-1-48000.wav", skip_ms=cmd_list[0][3] / 2)
+    assert len(runs) == len(cmd_list) - 1
+    for run, cmd in zip(runs, cmd_list[1:]):
+        outage_ms = 1000 * run / sample_rate
+        max_outage_ms = FILTER_DELAY_MS[(cmd[0], cmd[2])] + OUTAGE_MARGIN_MS
+        print(f"{cmd[0]} to {cmd[2]}: outage {outage_ms:.3f} ms, max {max_outage_ms:.3f} ms")
+        assert outage_ms <= max_outage_ms
 
 # For local test only
 if __name__ == "__main__":
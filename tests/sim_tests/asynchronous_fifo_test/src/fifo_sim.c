@@ -0,0 +1,60 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <string.h>
+#include "fifo_sim.h"
+
+void fifo_sim_init(fifo_sim_t *sim, int64_t producer_period, int producer_block,
+                   int consumers, int64_t consumer_period) {
+    memset(sim, 0, sizeof(*sim));
+    sim->producer_period = producer_period;
+    sim->producer_block = producer_block;
+    sim->consumers = consumers;
+    sim->consumer_period = consumer_period;
+    for(int i = 0; i < consumers; i++) {
+        sim->consumer_block[i] = 1;
+    }
+}
+
+int64_t fifo_sim_put_due(const fifo_sim_t *sim) {
+    return sim->producer_time + sim->producer_block * sim->producer_period;
+}
+
+int fifo_sim_next(fifo_sim_t *sim, int64_t *time) {
+    int64_t due = fifo_sim_put_due(sim);
+    int64_t next_time = due > sim->producer_hold ? due : sim->producer_hold;
+    int next = FIFO_SIM_PRODUCER;
+
+    for(int i = 0; i < sim->consumers; i++) {
+        int64_t t = sim->consumer_time[i] + sim->consumer_block[i] * sim->consumer_period;
+        if (t < next_time) {
+            next = i;
+            next_time = t;
+        }
+    }
+    if (next == FIFO_SIM_PRODUCER) {
+        sim->producer_time = due;
+        *time = due;
+    } else {
+        sim->consumer_time[next] = next_time;
+        *time = next_time;
+    }
+    return next;
+}
+
+void fifo_sim_asrc_init(fifo_sim_asrc_t *asrc, int in_fs, int out_fs, int64_t producer_period, int block) {
+    asrc->frames_per_put = ((int64_t)block * out_fs << 32) / in_fs;
+    asrc->frame_spacing = producer_period * in_fs / out_fs;
+    asrc->frames = 0;
+}
+
+int fifo_sim_asrc_step(fifo_sim_asrc_t *asrc, int32_t ratio, int64_t time, int64_t *timestamp) {
+    // A ratio r stretches the output by 1 + r/2^32
+    asrc->frames += asrc->frames_per_put - ((asrc->frames_per_put * ratio) >> 32);
+    int n = (int)(asrc->frames >> 32);
+    asrc->frames -= (uint64_t)n << 32;
+    // The last output frame is the fraction of a frame still owed before the end of the block
+    int64_t spacing = asrc->frame_spacing + ((asrc->frame_spacing * ratio) >> 32);
+    *timestamp = time - (int64_t)((asrc->frames * (uint64_t)spacing) >> 32);
+    return n;
+}
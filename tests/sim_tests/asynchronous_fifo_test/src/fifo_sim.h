@@ -0,0 +1,84 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef _FIFO_SIM_H_
+#define _FIFO_SIM_H_
+
+#include <stdint.h>
+
+// Shared by the test cases unless a case needs something else
+#define FIFO_LENGTH         (32)
+#define CHANNELS            (2)
+#define BLOCK_SIZE          (4)
+#define PRODUCER_PPM        (100)           // The producer runs this much fast
+
+#define FIFO_SIM_MAX_CONSUMERS  (2)
+#define FIFO_SIM_PRODUCER       (-1)
+
+/** Sample period in 1/2^16 ticks of a clock at fs, ppm fast */
+#define FIFO_SIM_PERIOD(fs, ppm) \
+    ((((int64_t)100000000 << 16) / (fs)) * (1000000 - (ppm)) / 1000000)
+
+/**
+ * Orders the puts of one producer and the gets of one or more consumers in
+ * time. All times are in 1/2^16 ticks. Each call to fifo_sim_next() returns
+ * whichever is due first, the producer on a tie, and moves its time on by
+ * one block.
+ */
+typedef struct {
+    int64_t  producer_period;               // Per frame
+    int64_t  producer_time;                 // Of the last put
+    int64_t  producer_hold;                 // No put happens before this time
+    int      producer_block;                // Frames per put
+    int      consumers;
+    int64_t  consumer_period;
+    int64_t  consumer_time[FIFO_SIM_MAX_CONSUMERS]; // Of the last get
+    int      consumer_block[FIFO_SIM_MAX_CONSUMERS]; // Frames per get
+} fifo_sim_t;
+
+/**
+ * Starts a simulation with the producer putting producer_block frames per
+ * producer_period and consumers getting one frame per consumer_period. The
+ * caller may then change consumer_block[] and consumer_time[].
+ */
+void fifo_sim_init(fifo_sim_t *sim, int64_t producer_period, int producer_block,
+                   int consumers, int64_t consumer_period);
+
+/** Time the next put is due, ignoring producer_hold */
+int64_t fifo_sim_put_due(const fifo_sim_t *sim);
+
+/**
+ * Moves on to the next event. Returns FIFO_SIM_PRODUCER or the consumer
+ * index and sets *time to the time of the event. A put held back by
+ * producer_hold still returns the time it was due.
+ */
+int fifo_sim_next(fifo_sim_t *sim, int64_t *time);
+
+/**
+ * Stands in for an ASRC in front of the producer: each put of a block of
+ * input samples produces the number of output frames that the last ratio
+ * asks for, and is timestamped with the time of the last of them, as
+ * asrc_timestamp_interpolation() would. Output frames are counted in
+ * 1/2^32 frames.
+ */
+typedef struct {
+    int64_t  frames_per_put;                // At the nominal ratio
+    int64_t  frame_spacing;                 // Producer time between output frames
+    uint64_t frames;                        // Fraction of a frame still owed
+} fifo_sim_asrc_t;
+
+/** Starts an ASRC from in_fs to out_fs whose input runs at producer_period */
+void fifo_sim_asrc_init(fifo_sim_asrc_t *asrc, int in_fs, int out_fs, int64_t producer_period, int block);
+
+/**
+ * Converts the block put at time with the given ratio. Returns the number
+ * of output frames and sets *timestamp to the time of the last of them.
+ */
+int fifo_sim_asrc_step(fifo_sim_asrc_t *asrc, int32_t ratio, int64_t time, int64_t *timestamp);
+
+/** Time of the last put in whole ticks, to end a run on */
+static inline int32_t fifo_sim_ticks(const fifo_sim_t *sim) {
+    return (int32_t)(sim->producer_time >> 16);
+}
+
+#endif
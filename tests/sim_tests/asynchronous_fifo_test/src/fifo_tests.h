@@ -0,0 +1,14 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef _FIFO_TESTS_H_
+#define _FIFO_TESTS_H_
+
+// Each case returns the number of errors it found
+int test_broadcast(void);
+int test_format(void);
+int test_pid(void);
+int test_stats(void);
+int test_wrap(void);
+
+#endif
@@ -0,0 +1,47 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Tests of the asynchronous FIFO in the simulator. Takes the name of one
+// case, or runs them all without one, and prints PASS or exits non zero.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fifo_tests.h"
+
+typedef struct {
+    const char *name;
+    int (*run)(void);
+} test_case_t;
+
+static const test_case_t cases[] = {
+    {"broadcast", test_broadcast},
+    {"format",    test_format},
+    {"pid",       test_pid},
+    {"stats",     test_stats},
+    {"wrap",      test_wrap},
+};
+
+int main(int argc, char **argv) {
+    int errors = 0;
+    int found = 0;
+
+    for(int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (argc < 2 || strcmp(argv[1], cases[i].name) == 0) {
+            printf("Case %s\n", cases[i].name);
+            errors += cases[i].run();
+            found++;
+        }
+    }
+    if (!found) {
+        printf("Unknown case %s\n", argv[1]);
+        exit(1);
+    }
+
+    if (errors) {
+        printf("FAIL: %d errors\n", errors);
+        exit(1);
+    }
+    printf("PASS\n");
+    return 0;
+}
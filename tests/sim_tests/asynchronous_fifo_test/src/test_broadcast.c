@@ -0,0 +1,163 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks a broadcast asynchronous FIFO with two consumers on the same clock.
+// Every frame holds a running count, so a consumer that reads a frame out of
+// order, for example one overwritten before it was read, shows as a jump in
+// the count between two successful gets. In the stall runs consumer 1 stops
+// pulling for a while: it must overflow and reset on its own, must not read
+// any of the frames that were overwritten meanwhile, and consumer 0 must not
+// notice. Only consumer 0 runs a PID: consumer 1 must report its phase
+// error, a third of a period behind consumer 0's on the same clock, and be
+// locked, but have no ratio.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asynchronous_fifo.h"
+#include "src.h"
+#include "fifo_sim.h"
+#include "fifo_tests.h"
+
+#define CONSUMERS           (2)
+#define SIMULATED_TICKS     (50000000)      // Half a second
+#define STALL_START         (10000000)      // Consumer 1 stops pulling for 50 ms
+#define STALL_END           (15000000)
+#define PHASE_TOLERANCE     (16)            // Ticks
+
+#define MODE_SAME_CLOCK     (0)
+#define MODE_STALL          (1)
+#define MODE_STALL_BULK     (2)
+
+static int64_t array[ASYNCHRONOUS_FIFO_BROADCAST_INT64_ELEMENTS(FIFO_LENGTH, CHANNELS, ASYNCH_FIFO_FORMAT_INT32, 1, CONSUMERS)];
+
+typedef struct {
+    int32_t  last;                          // Count of the last frame got, 0 after a failed get
+    uint32_t frames;                        // Frames got successfully
+    uint32_t failed_gets;
+    uint32_t jumps;                         // Successive frames whose counts are not consecutive
+} consumer_check_t;
+
+/*
+ * Checks the n frames of a get. Frame k of the stream holds k * CHANNELS + c
+ * in channel c, from k = 1; the frames the FIFO starts with hold zeros.
+ */
+static void check_frames(consumer_check_t *check, asynchronous_fifo_get_return_t ret, int32_t *out, int n) {
+    if (ret != ASYNCH_FIFO_OK) {
+        check->failed_gets++;
+        check->last = 0;
+        return;
+    }
+    for(int i = 0; i < n; i++) {
+        int32_t count = out[i * CHANNELS] / CHANNELS;
+        for(int c = 0; c < CHANNELS; c++) {
+            if (count != 0 && out[i * CHANNELS + c] != count * CHANNELS + c) {
+                check->jumps++;
+            }
+        }
+        if (count != 0 && check->last != 0 && count != check->last + 1) {
+            check->jumps++;
+        }
+        check->last = count;
+        check->frames++;
+    }
+}
+
+/*
+ * Runs one producer and two 48 kHz consumers for SIMULATED_TICKS, with the
+ * put and get events interleaved in time order. Consumer 1 runs a third of
+ * a sample period behind consumer 0.
+ */
+static int run_fifo(int mode) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array;
+    asynchronous_fifo_t *consumer[CONSUMERS];
+    asynchronous_fifo_stats_t stats[CONSUMERS];
+    consumer_check_t check[CONSUMERS];
+    int32_t samples[BLOCK_SIZE * CHANNELS];
+    fifo_sim_t sim;
+    int32_t count = 1;
+    int errors = 0;
+
+    fifo_sim_init(&sim, FIFO_SIM_PERIOD(48000, PRODUCER_PPM), BLOCK_SIZE, CONSUMERS, FIFO_SIM_PERIOD(48000, 0));
+    sim.consumer_time[1] = sim.consumer_period / 3;
+    if (mode == MODE_STALL_BULK) {
+        sim.consumer_block[1] = BLOCK_SIZE;
+    }
+    asynchronous_fifo_broadcast_init(fifo, CONSUMERS, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, 1);
+    for(int i = 0; i < CONSUMERS; i++) {
+        consumer[i] = asynchronous_fifo_broadcast_consumer(fifo, i);
+        asynchronous_fifo_init_PID_fs_codes(consumer[i], FS_CODE_48, FS_CODE_48);
+        asynchronous_fifo_enable_stats(consumer[i], &stats[i]);
+    }
+    memset(check, 0, sizeof(check));
+
+    while (fifo_sim_ticks(&sim) < SIMULATED_TICKS) {
+        int64_t time;
+        int next = fifo_sim_next(&sim, &time);
+        if (next == FIFO_SIM_PRODUCER) {
+            for(int i = 0; i < BLOCK_SIZE; i++) {
+                for(int c = 0; c < CHANNELS; c++) {
+                    samples[i * CHANNELS + c] = count * CHANNELS + c;
+                }
+                count++;
+            }
+            asynchronous_fifo_producer_put(fifo, samples, BLOCK_SIZE, (int32_t)(time >> 16));
+        } else {
+            int32_t out[BLOCK_SIZE * CHANNELS];
+            int32_t ts = (int32_t)(time >> 16);
+            int n = sim.consumer_block[next];
+            if (mode != MODE_SAME_CLOCK && next == 1 && ts >= STALL_START && ts < STALL_END) {
+                continue;
+            }
+            asynchronous_fifo_get_return_t ret;
+            if (n > 1) {
+                ret = asynchronous_fifo_consumer_get_bulk(consumer[next], out, n, ts, 0);
+            } else {
+                ret = asynchronous_fifo_consumer_get(consumer[next], out, ts);
+            }
+            check_frames(&check[next], ret, out, n);
+        }
+    }
+
+    for(int i = 0; i < CONSUMERS; i++) {
+        asynchronous_fifo_get_stats(consumer[i], &stats[i]);
+        printf("mode %d consumer %d: ratio %d phase error %d frames %u failed gets %u jumps %u overflows %u underflows %u resets %u\n",
+               mode, i, (int)consumer[i]->ratio, (int)consumer[i]->last_phase_error, (unsigned)check[i].frames,
+               (unsigned)check[i].failed_gets, (unsigned)check[i].jumps, (unsigned)stats[i].overflows,
+               (unsigned)stats[i].underflows, (unsigned)stats[i].resets);
+        if (check[i].jumps != 0 || check[i].last == 0) {
+            errors++;
+        }
+    }
+    // Consumer 0 is never disturbed, consumer 1 only by its own stall
+    if (check[0].failed_gets != 0 || stats[0].overflows + stats[0].underflows + stats[0].resets != 0) {
+        errors++;
+    }
+    if (mode == MODE_SAME_CLOCK) {
+        if (check[1].failed_gets != 0 || stats[1].overflows + stats[1].underflows + stats[1].resets != 0) {
+            errors++;
+        }
+    } else if (stats[1].overflows != 1 || stats[1].underflows != 1 || stats[1].resets != 1) {
+        errors++;
+    }
+    // Consumer 1 measures but does not run a PID; on the same clock it reads a third of a period later
+    if (consumer[1]->ratio != 0 || stats[1].ratio != 0 || stats[1].locked_frames == 0) {
+        errors++;
+    }
+    if (mode == MODE_SAME_CLOCK &&
+        llabs(consumer[1]->last_phase_error - consumer[0]->last_phase_error - (sim.consumer_period >> 16) / 3) > PHASE_TOLERANCE) {
+        errors++;
+    }
+    asynchronous_fifo_exit(fifo);
+    return errors;
+}
+
+int test_broadcast(void) {
+    int errors = 0;
+
+    for(int mode = MODE_SAME_CLOCK; mode <= MODE_STALL_BULK; mode++) {
+        errors += run_fifo(mode);
+    }
+    return errors;
+}
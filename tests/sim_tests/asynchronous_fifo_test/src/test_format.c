@@ -0,0 +1,352 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks the storage options of the asynchronous FIFO:
+// - packed 24-bit and 16-bit frames of 1 to 7 channels, which includes
+//   every size of part filled packing group, read back the most significant
+//   bits of the samples that were put;
+// - bulk gets, interleaved and planar, return the same samples, status and
+//   fill level as the same number of single gets, including reads that cross
+//   the end of the buffer;
+// - with one timestamp per K frames the FIFO returns the same samples and a
+//   ratio within a small tolerance of one that records every timestamp;
+// - a K that is not a power of two or is above a quarter of the FIFO is
+//   rejected;
+// - in adaptive depth mode, which would otherwise lower the fill level below
+//   K, the target stops just above K and the FIFO stays locked.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asynchronous_fifo.h"
+#include "src.h"
+#include "fifo_sim.h"
+#include "fifo_tests.h"
+
+#define MAX_CHANNELS        (7)
+#define MAX_GET             (5)             // Largest bulk get
+#define N_PUTS              (2000)
+#define SIMULATED_TICKS     (100000000)     // One second for the decimation runs
+#define GUARD               (0x5555555555555555ll)
+
+#define DECIMATION_TOLERANCE (4295 * 2)     // Of the ratio, 2 ppm
+
+// Low fill run: one frame per put brings the adaptive target down to about
+// 5 without decimation, so one timestamp per 8 frames must hold it up
+#define LOW_FILL_TICKS      (800000000)     // Eight seconds, the target comes down in about six
+#define LOW_FILL_DECIMATION (8)
+#define LOW_FILL_MARGIN     (1)
+#define LOW_FILL_WINDOW_MS  (100)
+#define LOW_FILL_BOOST      (3)
+#define LOW_FILL_MAX_PHASE_ERROR (1000)     // Ticks, a group stamped a lap late is off by thousands
+
+// Room for two FIFOs of the largest frames, each followed by a guard word
+static int64_t array[2][ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(FIFO_LENGTH, MAX_CHANNELS, ASYNCH_FIFO_FORMAT_INT32, 1) + 1];
+
+static const char *format_name(asynchronous_fifo_format_t format) {
+    return format == ASYNCH_FIFO_FORMAT_INT32 ? "int32" : format == ASYNCH_FIFO_FORMAT_PACKED24 ? "packed24" : "int16";
+}
+
+static uint32_t format_mask(asynchronous_fifo_format_t format) {
+    return format == ASYNCH_FIFO_FORMAT_INT32 ? 0xffffffffu : format == ASYNCH_FIFO_FORMAT_PACKED24 ? 0xffffff00u : 0xffff0000u;
+}
+
+static uint32_t random_sample(uint32_t *seed) {
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed;
+}
+
+/*
+ * Initialises FIFO i for the given frames and places a guard word straight
+ * after the int64_t elements it is allowed to use.
+ */
+static asynchronous_fifo_t *init_fifo(int i, int channels, int length, asynchronous_fifo_format_t format, int decimation) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array[i];
+    int elements = ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(length, channels, format, decimation);
+    array[i][elements] = GUARD;
+    asynchronous_fifo_init_format(fifo, channels, length, format, decimation);
+    asynchronous_fifo_init_PID_fs_codes(fifo, FS_CODE_48, FS_CODE_48);
+    return fifo;
+}
+
+static int guard_ok(int i, int channels, int length, asynchronous_fifo_format_t format, int decimation) {
+    return array[i][ASYNCHRONOUS_FIFO_INT64_ELEMENTS_FORMAT(length, channels, format, decimation)] == GUARD;
+}
+
+/*
+ * Puts and gets random frames at the nominal rate. The FIFO starts half
+ * full of zeros, so get k returns frame k - length/2.
+ */
+static int test_round_trip(int channels, int length, asynchronous_fifo_format_t format) {
+    static int32_t history[N_PUTS * BLOCK_SIZE][MAX_CHANNELS];
+    asynchronous_fifo_t *fifo = init_fifo(0, channels, length, format, 1);
+    uint32_t mask = format_mask(format);
+    uint32_t seed = channels * 7 + format;
+    int32_t timestamp = 0;
+    int frame = 0;
+    int errors = 0;
+
+    for(int p = 0; p < N_PUTS; p++) {
+        int32_t samples[BLOCK_SIZE * MAX_CHANNELS];
+        for(int i = 0; i < BLOCK_SIZE; i++) {
+            for(int c = 0; c < channels; c++) {
+                samples[i * channels + c] = history[p * BLOCK_SIZE + i][c] = random_sample(&seed);
+            }
+        }
+        timestamp += BLOCK_SIZE * 2083;
+        asynchronous_fifo_producer_put(fifo, samples, BLOCK_SIZE, timestamp);
+        for(int i = 0; i < BLOCK_SIZE; i++) {
+            int32_t out[MAX_CHANNELS];
+            if (asynchronous_fifo_consumer_get(fifo, out, timestamp + i * 2083) != ASYNCH_FIFO_OK) {
+                errors++;
+            }
+            int source = frame - length / 2;
+            for(int c = 0; c < channels; c++) {
+                uint32_t expected = source < 0 ? 0 : (uint32_t)history[source][c] & mask;
+                if ((uint32_t)out[c] != expected) {
+                    errors++;
+                }
+            }
+            frame++;
+        }
+    }
+    if (!guard_ok(0, channels, length, format, 1)) {
+        errors++;
+    }
+    printf("round trip %-8s channels %d length %d: %d errors\n", format_name(format), channels, length, errors);
+    asynchronous_fifo_exit(fifo);
+    return errors;
+}
+
+/*
+ * Runs two identical FIFOs side by side, one emptied with single gets and
+ * one with bulk gets of 3 and 5 frames in turn, so that the bulk reads start
+ * at many offsets and some cross the end of the buffer.
+ */
+static int test_bulk(int channels, int length, asynchronous_fifo_format_t format, int planar) {
+    asynchronous_fifo_t *single = init_fifo(0, channels, length, format, 1);
+    asynchronous_fifo_t *bulk = init_fifo(1, channels, length, format, 1);
+    uint32_t seed = channels * 13 + format;
+    int32_t timestamp = 0, put_timestamp = 2083;
+    int wraps = 0;
+    int errors = 0;
+
+    // Read one frame first, so that the reads are not aligned with the buffer
+    int32_t first[MAX_CHANNELS];
+    timestamp += 2083;
+    asynchronous_fifo_consumer_get(single, first, timestamp);
+    asynchronous_fifo_consumer_get(bulk, first, timestamp);
+
+    for(int p = 0; p < N_PUTS; p++) {
+        int32_t samples[BLOCK_SIZE * MAX_CHANNELS];
+        for(int i = 0; i < BLOCK_SIZE * channels; i++) {
+            samples[i] = random_sample(&seed);
+        }
+        put_timestamp += BLOCK_SIZE * 2083;
+        int32_t ratio_single = asynchronous_fifo_producer_put(single, samples, BLOCK_SIZE, put_timestamp);
+        int32_t ratio_bulk = asynchronous_fifo_producer_put(bulk, samples, BLOCK_SIZE, put_timestamp);
+        if (ratio_single != ratio_bulk) {
+            errors++;
+        }
+        if (p & 1) {
+            // Eight frames over two puts, as 3 + 5 or 5 + 3
+            for(int g = 0; g < 2; g++) {
+                int n = ((p >> 1) + g) & 1 ? 5 : 3;
+                int32_t expected[MAX_GET * MAX_CHANNELS], out[MAX_GET * MAX_CHANNELS];
+                asynchronous_fifo_get_return_t ret_single = ASYNCH_FIFO_OK;
+                uint32_t read_index = bulk->read_ptr & bulk->index_mask;
+                for(int k = 0; k < n; k++) {
+                    timestamp += 2083;
+                    asynchronous_fifo_get_return_t ret = asynchronous_fifo_consumer_get(single, expected + k * channels, timestamp);
+                    if (ret != ASYNCH_FIFO_OK) {
+                        ret_single = ret;
+                    }
+                }
+                asynchronous_fifo_get_return_t ret_bulk =
+                    asynchronous_fifo_consumer_get_bulk(bulk, out, n, timestamp, planar ? MAX_GET : 0);
+                if (ret_single != ret_bulk || single->read_ptr != bulk->read_ptr) {
+                    errors++;
+                }
+                for(int k = 0; k < n; k++) {
+                    for(int c = 0; c < channels; c++) {
+                        int32_t got = planar ? out[c * MAX_GET + k] : out[k * channels + c];
+                        if (got != expected[k * channels + c]) {
+                            errors++;
+                        }
+                    }
+                }
+                if (read_index + n > (uint32_t)length) {
+                    wraps++;
+                }
+            }
+        }
+    }
+    if (wraps == 0 || !guard_ok(0, channels, length, format, 1) || !guard_ok(1, channels, length, format, 1)) {
+        errors++;
+    }
+    printf("bulk %-8s channels %d length %d %s: %d wrapped reads, %d errors\n", format_name(format), channels,
+           length, planar ? "planar" : "interleaved", wraps, errors);
+    asynchronous_fifo_exit(single);
+    asynchronous_fifo_exit(bulk);
+    return errors;
+}
+
+/*
+ * Runs a FIFO with one timestamp per decimation frames next to one that
+ * records them all, with a slightly fast producer and the put and get events
+ * interleaved in time order. The samples must match exactly and the ratios
+ * closely.
+ */
+static int test_decimation(int decimation) {
+    asynchronous_fifo_t *full = init_fifo(0, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, 1);
+    asynchronous_fifo_t *decimated = init_fifo(1, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, decimation);
+    asynchronous_fifo_stats_t stats;
+    fifo_sim_t sim;
+    uint32_t seed = decimation;
+    int32_t ratio_full = 0, ratio_decimated = 0;
+    int errors = 0;
+
+    fifo_sim_init(&sim, FIFO_SIM_PERIOD(48000, PRODUCER_PPM), BLOCK_SIZE, 1, FIFO_SIM_PERIOD(48000, 0));
+    asynchronous_fifo_enable_stats(decimated, &stats);
+    while (fifo_sim_ticks(&sim) < SIMULATED_TICKS) {
+        int64_t time;
+        int32_t ts;
+        if (fifo_sim_next(&sim, &time) == FIFO_SIM_PRODUCER) {
+            int32_t samples[BLOCK_SIZE * CHANNELS];
+            for(int i = 0; i < BLOCK_SIZE * CHANNELS; i++) {
+                samples[i] = random_sample(&seed);
+            }
+            ts = (int32_t)(time >> 16);
+            ratio_full = asynchronous_fifo_producer_put(full, samples, BLOCK_SIZE, ts);
+            ratio_decimated = asynchronous_fifo_producer_put(decimated, samples, BLOCK_SIZE, ts);
+        } else {
+            int32_t expected[CHANNELS], out[CHANNELS];
+            ts = (int32_t)(time >> 16);
+            asynchronous_fifo_get_return_t ret_full = asynchronous_fifo_consumer_get(full, expected, ts);
+            asynchronous_fifo_get_return_t ret_decimated = asynchronous_fifo_consumer_get(decimated, out, ts);
+            if (ret_full != ret_decimated || memcmp(expected, out, sizeof(out)) != 0) {
+                errors++;
+            }
+        }
+    }
+    asynchronous_fifo_get_stats(decimated, &stats);
+    if (abs(ratio_full - ratio_decimated) > DECIMATION_TOLERANCE ||
+        stats.overflows + stats.underflows + stats.resets != 0 ||
+        !guard_ok(1, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, decimation)) {
+        errors++;
+    }
+    printf("decimation %d: ratio %d %d, %d errors\n", decimation, (int)ratio_full, (int)ratio_decimated, errors);
+    asynchronous_fifo_exit(full);
+    asynchronous_fifo_exit(decimated);
+    return errors;
+}
+
+/*
+ * Checks that decimations that are not a power of two, or leave fewer than
+ * four groups, are rejected, and that the FIFO is left as it was.
+ */
+static int test_decimation_checks(void) {
+    static const struct {
+        int length;
+        int decimation;
+        int ok;
+    } checks[] = {
+        {FIFO_LENGTH, 1, 1}, {FIFO_LENGTH, 2, 1}, {FIFO_LENGTH, FIFO_LENGTH / 4, 1},
+        {FIFO_LENGTH, 0, 0}, {FIFO_LENGTH, 3, 0}, {FIFO_LENGTH, 6, 0}, {FIFO_LENGTH, FIFO_LENGTH / 2, 0},
+        {FIFO_LENGTH - 2, FIFO_LENGTH / 4, 0}, {4, 1, 1}, {4, 2, 0},
+    };
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array[0];
+    int errors = 0;
+
+    for(int i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        memset(array[0], 0x55, sizeof(array[0]));
+        int ret = asynchronous_fifo_init_format(fifo, CHANNELS, checks[i].length, ASYNCH_FIFO_FORMAT_INT32,
+                                                checks[i].decimation);
+        int ret_broadcast = asynchronous_fifo_broadcast_init(fifo, 1, CHANNELS, checks[i].length,
+                                                             ASYNCH_FIFO_FORMAT_INT32, checks[i].decimation);
+        if (ret != (checks[i].ok ? 0 : -1) || ret_broadcast != ret ||
+            (!checks[i].ok && array[0][0] != GUARD)) {
+            printf("decimation %d length %d: returned %d %d\n", checks[i].decimation, checks[i].length,
+                   ret, ret_broadcast);
+            errors++;
+        }
+    }
+    printf("decimation checks: %d errors\n", errors);
+    return errors;
+}
+
+/*
+ * Closes the loop around a FIFO with decimated timestamps in adaptive depth
+ * mode, with one frame per put so that the fill level would go well below
+ * the decimation. The target must come down to just above it and no
+ * further, and the FIFO must stay locked without a reset.
+ */
+static int test_low_fill(void) {
+    asynchronous_fifo_t *fifo = init_fifo(0, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, LOW_FILL_DECIMATION);
+    asynchronous_fifo_stats_t stats;
+    int32_t samples[2 * CHANNELS] = {0};
+    fifo_sim_t sim;
+    fifo_sim_asrc_t asrc;
+    int window_puts = 48000 * LOW_FILL_WINDOW_MS / 1000;
+    int32_t expected_ratio = (int32_t)(((int64_t)PRODUCER_PPM << 32) / 1000000);
+    int32_t ratio = 0, target_min = FIFO_LENGTH;
+    int errors = 0;
+
+    fifo_sim_init(&sim, FIFO_SIM_PERIOD(48000, PRODUCER_PPM), 1, 1, FIFO_SIM_PERIOD(48000, 0));
+    fifo_sim_asrc_init(&asrc, 48000, 48000, sim.producer_period, 1);
+    asynchronous_fifo_init_PID_schedule(fifo, LOW_FILL_BOOST, 32, window_puts);
+    asynchronous_fifo_init_adaptive_depth(fifo, LOW_FILL_MARGIN, window_puts);
+    asynchronous_fifo_enable_stats(fifo, &stats);
+    while (fifo_sim_ticks(&sim) < LOW_FILL_TICKS) {
+        int64_t time;
+        if (fifo_sim_next(&sim, &time) == FIFO_SIM_PRODUCER) {
+            int64_t timestamp;
+            int n = fifo_sim_asrc_step(&asrc, ratio, time, &timestamp);
+            ratio = asynchronous_fifo_producer_put(fifo, samples, n, (int32_t)(timestamp >> 16));
+            target_min = fifo->target_depth < target_min ? fifo->target_depth : target_min;
+        } else {
+            int32_t out[CHANNELS];
+            asynchronous_fifo_consumer_get(fifo, out, (int32_t)(time >> 16));
+        }
+    }
+    asynchronous_fifo_get_stats(fifo, &stats);
+    printf("low fill decimation %d: target down to %d, fill %d to %d, max phase error %d, ratio %d (%d), resets %u\n",
+           LOW_FILL_DECIMATION, (int)target_min, (int)stats.min_fill, (int)stats.max_fill,
+           (int)stats.max_phase_error, (int)ratio, (int)expected_ratio,
+           (unsigned)(stats.resets + stats.underflows + stats.overflows));
+    if (stats.resets + stats.underflows + stats.overflows != 0 || target_min < LOW_FILL_DECIMATION ||
+        target_min > LOW_FILL_DECIMATION + 2 || stats.locked_frames == 0 ||
+        stats.max_phase_error > LOW_FILL_MAX_PHASE_ERROR || abs(ratio - expected_ratio) > DECIMATION_TOLERANCE ||
+        !guard_ok(0, CHANNELS, FIFO_LENGTH, ASYNCH_FIFO_FORMAT_INT32, LOW_FILL_DECIMATION)) {
+        errors++;
+    }
+    asynchronous_fifo_exit(fifo);
+    return errors;
+}
+
+int test_format(void) {
+    static const asynchronous_fifo_format_t formats[] = {
+        ASYNCH_FIFO_FORMAT_INT32, ASYNCH_FIFO_FORMAT_PACKED24, ASYNCH_FIFO_FORMAT_INT16};
+    // A power of two depth uses masked counters, any other wraps with a compare
+    static const int lengths[] = {FIFO_LENGTH, FIFO_LENGTH - 2};
+    int errors = 0;
+
+    for(int f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for(int channels = 1; channels <= MAX_CHANNELS; channels++) {
+            errors += test_round_trip(channels, FIFO_LENGTH, formats[f]);
+        }
+        for(int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            for(int channels = 1; channels <= MAX_CHANNELS; channels += 3) {
+                errors += test_bulk(channels, lengths[l], formats[f], 0);
+                errors += test_bulk(channels, lengths[l], formats[f], 1);
+            }
+        }
+    }
+    for(int decimation = 2; decimation <= 8; decimation *= 2) {
+        errors += test_decimation(decimation);
+    }
+    errors += test_decimation_checks();
+    errors += test_low_fill();
+    return errors;
+}
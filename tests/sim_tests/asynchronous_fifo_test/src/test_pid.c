@@ -0,0 +1,288 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Closes the loop around the asynchronous FIFO PID. The producer stands in
+// for an ASRC, see fifo_sim_asrc_step(). The consumer takes frames at
+// exactly 48 kHz and the input clock is a little fast or slow. Checks that:
+// - with a gain boost the boost steps down one at a time to 0, the phase
+//   error settles well within a second and stays settled, and the ratio
+//   ends within 1 ppm of the actual clock ratio;
+// - once locked, the ratio from asynchronous_fifo_producer_put_fract()
+//   varies less than that from asynchronous_fifo_producer_put();
+// - without a boost the loop takes more than twice as long to settle;
+// - against the lock criterion and ppm range of test_asrc_ppm.py, with its
+//   deep FIFO and 6 s runs, both the plain loop and the boosted one lock
+//   at 2000 ppm with 4 or 5 frames per put, and the boosted one at 5000 ppm
+//   within a second;
+// - in adaptive depth mode the target fill level stays within 1 and half
+//   the FIFO, comes down from half, and goes up again when a late put eats
+//   into the margin, without the FIFO resetting.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "asynchronous_fifo.h"
+#include "src.h"
+#include "fifo_sim.h"
+#include "fifo_tests.h"
+
+#define SIMULATED_TICKS     (300000000)     // Three seconds
+#define SETTLE_TICKS        (32)            // As asrc_task
+#define SETTLE_MS           (100)
+#define SETTLED_ERROR_TICKS (64)            // Phase error that counts as settled
+#define RATIO_TOLERANCE     (4295)          // Of the ratio, 1 ppm
+#define ADAPTIVE_TICKS      (1000000000)    // Ten seconds for adaptive depth mode
+#define ADAPTIVE_WINDOW_MS  (100)
+#define ADAPTIVE_MARGIN     (2)
+#define HICCUP_TICKS        (800000000)     // After the target has come down
+#define HICCUP_FRAMES       (ADAPTIVE_MARGIN + 1) // Eats the margin, but does not underflow
+#define PPM_FIFO_LENGTH     (1280)          // As test_asrc_ppm.py
+#define PPM_TICKS           (600000000)     // Six seconds
+#define LOCK_ERROR_TICKS    (100)           // Mean and peak phase error over 100 ms that count as locked
+
+static int64_t array[ASYNCHRONOUS_FIFO_INT64_ELEMENTS(PPM_FIFO_LENGTH, CHANNELS)];
+
+typedef struct {
+    int      boost;                         // log2 of the gain boost
+    int      fract;                         // 1 for asynchronous_fifo_producer_put_fract()
+    int      in_fs_code;                    // Input rate, the output is 48 kHz
+    int      in_fs;
+    int      ppm;                           // Input clock error
+    int      margin;                        // Adaptive depth margin, 0 for off
+    int      fifo_length;                   // 0 for FIFO_LENGTH
+    int32_t  run_ticks;                     // 0 for SIMULATED_TICKS, or ADAPTIVE_TICKS with a margin
+} loop_config_t;
+
+typedef struct {
+    int32_t  ratio;
+    int32_t  ratio_min;                     // Over the last third of the run
+    int32_t  ratio_max;
+    int32_t  settle_ticks;                  // Time of the last phase error above SETTLED_ERROR_TICKS
+    int32_t  boost_off_ticks;               // Time the boost reached 0
+    int32_t  lock_ticks;                    // Time of lock as test_asrc_ppm.py sees it, -1 for never
+    int      boost_steps;                   // Times the boost changed
+    int      boost_errors;                  // Times it went up, or down by more than one
+    int32_t  target_min;                    // Target fill level in adaptive depth mode
+    int32_t  target_max;
+    int32_t  target_before_hiccup;
+    int32_t  target_after_hiccup;           // Highest after the hiccup
+    uint32_t resets;
+} loop_result_t;
+
+/*
+ * Runs the loop for SIMULATED_TICKS, or ADAPTIVE_TICKS in adaptive depth
+ * mode, unless the config sets its own run time. Lock is taken as
+ * analyse_lock() in test_asrc_ppm.py takes it: the start of the first
+ * 100 ms window, after the first and stepped by 50 ms, whose mean and peak
+ * phase error are both within LOCK_ERROR_TICKS. In adaptive depth mode a hiccup holds back the first put due
+ * after HICCUP_TICKS, and any others due before it is done, by
+ * HICCUP_FRAMES consumer periods, as a late ASRC block would; their
+ * timestamps are not affected.
+ */
+static void run_loop(const loop_config_t *config, loop_result_t *result) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array;
+    asynchronous_fifo_stats_t stats;
+    int32_t samples[(BLOCK_SIZE + 2) * CHANNELS] = {0}; // At most one more frame than BLOCK_SIZE at 44.1 kHz in
+    int32_t out[CHANNELS];
+    int64_t producer_period = FIFO_SIM_PERIOD(config->in_fs, config->ppm);
+    fifo_sim_t sim;
+    fifo_sim_asrc_t asrc;
+    int32_t ratio = 0;
+    int boost = config->boost;
+    int fifo_length = config->fifo_length ? config->fifo_length : FIFO_LENGTH;
+    int32_t run_ticks = config->run_ticks ? config->run_ticks : config->margin ? ADAPTIVE_TICKS : SIMULATED_TICKS;
+    int half_window = config->in_fs / (20 * BLOCK_SIZE);
+    int halves = 0, half_puts = 0;
+    int32_t half_sum = 0, half_peak = 0, last_half_sum = 0, last_half_peak = 0;
+    int64_t hiccup_start = config->margin ? (int64_t)HICCUP_TICKS << 16 : INT64_MAX;
+
+    fifo_sim_init(&sim, producer_period, BLOCK_SIZE, 1, FIFO_SIM_PERIOD(48000, 0));
+    fifo_sim_asrc_init(&asrc, config->in_fs, 48000, producer_period, BLOCK_SIZE);
+    asynchronous_fifo_init(fifo, CHANNELS, fifo_length);
+    asynchronous_fifo_init_PID_fs_codes(fifo, config->in_fs_code, FS_CODE_48);
+    asynchronous_fifo_init_PID_schedule(fifo, config->boost, SETTLE_TICKS,
+                                        config->in_fs * SETTLE_MS / (1000 * BLOCK_SIZE));
+    asynchronous_fifo_init_adaptive_depth(fifo, config->margin, config->in_fs * ADAPTIVE_WINDOW_MS / (1000 * BLOCK_SIZE));
+    asynchronous_fifo_enable_stats(fifo, &stats);
+    result->settle_ticks = 0;
+    result->boost_off_ticks = config->boost ? -1 : 0;
+    result->boost_steps = 0;
+    result->boost_errors = 0;
+    result->lock_ticks = -1;
+    result->ratio_min = INT32_MAX;
+    result->ratio_max = INT32_MIN;
+    result->target_min = INT32_MAX;
+    result->target_max = INT32_MIN;
+    result->target_before_hiccup = 0;
+    result->target_after_hiccup = 0;
+
+    while (fifo_sim_ticks(&sim) < run_ticks) {
+        int64_t time;
+        if (sim.producer_hold == 0 && fifo_sim_put_due(&sim) >= hiccup_start) {
+            sim.producer_hold = fifo_sim_put_due(&sim) + HICCUP_FRAMES * sim.consumer_period;
+        }
+        if (fifo_sim_next(&sim, &time) == FIFO_SIM_PRODUCER) {
+            int64_t timestamp;
+            int n = fifo_sim_asrc_step(&asrc, ratio, time, &timestamp);
+            if (config->fract) {
+                ratio = asynchronous_fifo_producer_put_fract(fifo, samples, n, (int32_t)(timestamp >> 16),
+                                                             (uint32_t)timestamp << 16);
+            } else {
+                ratio = asynchronous_fifo_producer_put(fifo, samples, n, (int32_t)(timestamp >> 16));
+            }
+            if (fifo_sim_ticks(&sim) > run_ticks / 3 * 2) {
+                result->ratio_min = ratio < result->ratio_min ? ratio : result->ratio_min;
+                result->ratio_max = ratio > result->ratio_max ? ratio : result->ratio_max;
+            }
+
+            int32_t phase_error = (int32_t)(fifo->last_phase_error >> (config->fract ? ASYNCHRONOUS_FIFO_PHASE_FRACT_BITS : 0));
+            if (abs(phase_error) > SETTLED_ERROR_TICKS) {
+                result->settle_ticks = fifo_sim_ticks(&sim);
+            }
+            half_sum += phase_error;
+            half_peak = abs(phase_error) > half_peak ? abs(phase_error) : half_peak;
+            if (++half_puts == half_window) {
+                // A window is this half and the last, the first one checked starts 100 ms in
+                if (++halves >= 4 && result->lock_ticks < 0 &&
+                    abs(half_sum + last_half_sum) < LOCK_ERROR_TICKS * 2 * half_window &&
+                    half_peak < LOCK_ERROR_TICKS && last_half_peak < LOCK_ERROR_TICKS) {
+                    result->lock_ticks = fifo_sim_ticks(&sim) - 100000000 / 10;
+                }
+                last_half_sum = half_sum;
+                last_half_peak = half_peak;
+                half_sum = 0;
+                half_peak = 0;
+                half_puts = 0;
+            }
+            if (fifo->gain_boost != boost) {
+                if (fifo->gain_boost != boost - 1) {
+                    result->boost_errors++;
+                }
+                boost = fifo->gain_boost;
+                result->boost_steps++;
+                if (boost == 0) {
+                    result->boost_off_ticks = fifo_sim_ticks(&sim);
+                }
+            }
+            if (config->margin) {
+                result->target_min = fifo->target_depth < result->target_min ? fifo->target_depth : result->target_min;
+                result->target_max = fifo->target_depth > result->target_max ? fifo->target_depth : result->target_max;
+                if (time < hiccup_start) {
+                    result->target_before_hiccup = fifo->target_depth;
+                } else if (fifo->target_depth > result->target_after_hiccup) {
+                    result->target_after_hiccup = fifo->target_depth;
+                }
+            }
+        } else {
+            asynchronous_fifo_consumer_get(fifo, out, (int32_t)(time >> 16));
+        }
+    }
+    asynchronous_fifo_get_stats(fifo, &stats);
+    result->ratio = ratio;
+    result->resets = stats.resets + stats.underflows + stats.overflows;
+    asynchronous_fifo_exit(fifo);
+}
+
+static int test_loop(const loop_config_t *config, loop_result_t *result) {
+    // The input is ppm fast, so the ratio is about ppm * 2^32 / 10^6
+    int32_t expected_ratio = (int32_t)(((int64_t)config->ppm << 32) / 1000000);
+    int errors = 0;
+
+    run_loop(config, result);
+    printf("boost %d %s in_fs %d ppm %d: ratio %d (%d) spread %d settled at %d ticks, boost off at %d ticks, %d steps, resets %u\n",
+           config->boost, config->fract ? "put_fract" : "put", config->in_fs, config->ppm, (int)result->ratio,
+           (int)expected_ratio, (int)(result->ratio_max - result->ratio_min), (int)result->settle_ticks, (int)result->boost_off_ticks, result->boost_steps,
+           (unsigned)result->resets);
+    if (result->resets != 0 || result->settle_ticks > SIMULATED_TICKS / 10 * 9) {
+        errors++;
+    }
+    if (config->boost) {
+        // Stepped down one at a time, to 0, settled within a second, and locked to within 1 ppm
+        if (result->boost_errors != 0 || result->boost_steps != config->boost || result->boost_off_ticks < 0 ||
+            result->settle_ticks > SIMULATED_TICKS / 3 || abs(result->ratio - expected_ratio) > RATIO_TOLERANCE ||
+            result->ratio_max - result->ratio_min > RATIO_TOLERANCE) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static int test_adaptive(const loop_config_t *config) {
+    loop_result_t result;
+    int errors = 0;
+
+    run_loop(config, &result);
+    printf("adaptive margin %d %s in_fs %d: target %d to %d, %d before the hiccup, up to %d after, resets %u\n",
+           config->margin, config->fract ? "put_fract" : "put", config->in_fs, (int)result.target_min,
+           (int)result.target_max, (int)result.target_before_hiccup, (int)result.target_after_hiccup,
+           (unsigned)result.resets);
+    // Never above half the FIFO, lowered from there and raised again by the hiccup, without a reset
+    if (result.resets != 0 || result.target_min < 1 || result.target_max > FIFO_LENGTH / 2 ||
+        result.target_before_hiccup >= FIFO_LENGTH / 2 - 1 ||
+        result.target_after_hiccup <= result.target_before_hiccup) {
+        errors++;
+    }
+    return errors;
+}
+
+static int test_ppm(const loop_config_t *config) {
+    loop_result_t result;
+    int errors = 0;
+
+    run_loop(config, &result);
+    printf("ppm limits boost %d in_fs %d ppm %d: locked at %d ticks, resets %u\n",
+           config->boost, config->in_fs, config->ppm, (int)result.lock_ticks, (unsigned)result.resets);
+    if (result.resets != 0 || result.lock_ticks < 0 || (config->boost && result.lock_ticks > PPM_TICKS / 6)) {
+        errors++;
+    }
+    return errors;
+}
+
+int test_pid(void) {
+    // Each rate with the integer and then the sub-tick phase detector
+    static const loop_config_t boosted[] = {
+        {3, 0, FS_CODE_48,  48000,  200},
+        {3, 1, FS_CODE_48,  48000,  200},
+        {3, 0, FS_CODE_48,  48000, -200},
+        {3, 1, FS_CODE_48,  48000, -200},
+        {3, 0, FS_CODE_192, 192000, 200},
+        {3, 1, FS_CODE_192, 192000, 200},
+        {3, 0, FS_CODE_44,  44100,   37},
+        {3, 1, FS_CODE_44,  44100,   37},
+    };
+    loop_config_t unboosted = boosted[0];
+    loop_result_t result, reference, put = {0};
+    int errors = 0;
+
+    for(int i = 0; i < sizeof(boosted) / sizeof(boosted[0]); i++) {
+        errors += test_loop(&boosted[i], &result);
+        if (i == 0) {
+            reference = result;
+        }
+        // Once locked, the sub-tick detector dithers the ratio less
+        if (boosted[i].fract) {
+            if (result.ratio_max - result.ratio_min > put.ratio_max - put.ratio_min) {
+                errors++;
+            }
+        } else {
+            put = result;
+        }
+    }
+    errors += test_adaptive(&(loop_config_t){3, 0, FS_CODE_48, 48000, 200, ADAPTIVE_MARGIN});
+    errors += test_adaptive(&(loop_config_t){3, 1, FS_CODE_192, 192000, -200, ADAPTIVE_MARGIN});
+
+    // Without the boost the same loop takes much longer to settle
+    unboosted.boost = 0;
+    run_loop(&unboosted, &result);
+    printf("boost 0: settled at %d ticks\n", (int)result.settle_ticks);
+    if (result.resets != 0 || result.settle_ticks < 2 * reference.settle_ticks) {
+        errors++;
+    }
+
+    // The corners of test_asrc_ppm.py that each loop reaches, with 4 or 5 frames per put
+    errors += test_ppm(&(loop_config_t){0, 0, FS_CODE_44, 44100, -2000, 0, PPM_FIFO_LENGTH, PPM_TICKS});
+    errors += test_ppm(&(loop_config_t){0, 0, FS_CODE_44, 44100,  2000, 0, PPM_FIFO_LENGTH, PPM_TICKS});
+    errors += test_ppm(&(loop_config_t){3, 0, FS_CODE_44, 44100, -5000, 0, PPM_FIFO_LENGTH, PPM_TICKS});
+    errors += test_ppm(&(loop_config_t){3, 0, FS_CODE_44, 44100,  5000, 0, PPM_FIFO_LENGTH, PPM_TICKS});
+    return errors;
+}
@@ -0,0 +1,196 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks the run time statistics of the asynchronous FIFO against a record
+// of the same run kept by the test. The producer stands in for a 48 kHz to
+// 48 kHz ASRC, see fifo_sim_asrc_step(), and starts with a gain boost,
+// so the FIFO is not locked at first, and part way through the consumer
+// stops pulling, so the FIFO overflows, underflows when the consumer comes
+// back, and resets. After every put the statistics must match the record:
+// - min_fill, max_fill and mean_fill of the fill levels seen before each put;
+// - max_phase_error and locked_frames since the PID reached its base gains,
+//   both starting again after the overflow and after the reset;
+// - one overflow, one underflow and one reset.
+// Without statistics, asynchronous_fifo_get_stats() must return a cleared
+// copy.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asynchronous_fifo.h"
+#include "src.h"
+#include "fifo_sim.h"
+#include "fifo_tests.h"
+
+#define SIMULATED_TICKS     (300000000)     // Three seconds
+#define STALL_START         (150000000)     // Consumer stops pulling for 20 ms, once locked
+#define STALL_END           (152000000)
+#define GAIN_BOOST          (3)             // As the pid case, locks in about a second
+#define SETTLE_TICKS        (32)
+#define SETTLE_PUTS         (1200)          // 100 ms at 48 kHz
+
+static int64_t array[ASYNCHRONOUS_FIFO_INT64_ELEMENTS(FIFO_LENGTH, CHANNELS)];
+
+typedef struct {
+    int32_t  min_fill;
+    int32_t  max_fill;
+    uint64_t fill_sum;
+    uint64_t fill_count;
+    uint32_t underflows;
+    uint32_t overflows;
+    uint32_t resets;
+    int32_t  max_phase_error;
+    uint64_t locked_frames;
+} stats_record_t;
+
+/*
+ * Adds a put of n frames to the record; len, reset and stopped are the fill
+ * level and the FIFO flags just before the put, as the producer sees them.
+ */
+static void record_put(stats_record_t *record, asynchronous_fifo_t *fifo, int n, int len, int reset, int stopped) {
+    if (reset) {
+        record->resets++;
+        record->locked_frames = 0;
+    } else if (len >= FIFO_LENGTH - 2 - n) {
+        if (!stopped) {
+            record->overflows++;
+            record->locked_frames = 0;
+        }
+    } else if (!stopped && n) {
+        record->min_fill = len < record->min_fill ? len : record->min_fill;
+        record->max_fill = len > record->max_fill ? len : record->max_fill;
+        record->fill_sum += len;
+        record->fill_count++;
+        if (fifo->skip_ctr == 0 && fifo->gain_boost == 0) {
+            int32_t phase_error = abs(fifo->last_phase_error);
+            if (record->locked_frames == 0 || phase_error > record->max_phase_error) {
+                record->max_phase_error = phase_error;
+            }
+            record->locked_frames += n;
+        }
+    }
+}
+
+static int compare(const stats_record_t *record, const asynchronous_fifo_stats_t *stats, int32_t ratio) {
+    int32_t mean_fill = record->fill_count ? (int32_t)((record->fill_sum << 8) / record->fill_count) : 0;
+    return stats->min_fill != record->min_fill || stats->max_fill != record->max_fill ||
+           stats->fill_sum != record->fill_sum || stats->fill_count != record->fill_count ||
+           stats->mean_fill != mean_fill || stats->underflows != record->underflows ||
+           stats->overflows != record->overflows || stats->resets != record->resets ||
+           stats->locked_frames != record->locked_frames || stats->ratio != ratio ||
+           (record->locked_frames != 0 && stats->max_phase_error != record->max_phase_error);
+}
+
+static int test_known_run(void) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array;
+    asynchronous_fifo_stats_t stats, copy;
+    stats_record_t record;
+    int32_t samples[(BLOCK_SIZE + 1) * CHANNELS] = {0};
+    fifo_sim_t sim;
+    fifo_sim_asrc_t asrc;
+    int32_t ratio = 0;
+    uint64_t locked_before_overflow = 0, locked_after_overflow = 1, locked_after_reset = 1;
+    int mismatches = 0;
+    int errors = 0;
+
+    fifo_sim_init(&sim, FIFO_SIM_PERIOD(48000, PRODUCER_PPM), BLOCK_SIZE, 1, FIFO_SIM_PERIOD(48000, 0));
+    fifo_sim_asrc_init(&asrc, 48000, 48000, sim.producer_period, BLOCK_SIZE);
+    asynchronous_fifo_init(fifo, CHANNELS, FIFO_LENGTH);
+    asynchronous_fifo_init_PID_fs_codes(fifo, FS_CODE_48, FS_CODE_48);
+    asynchronous_fifo_init_PID_schedule(fifo, GAIN_BOOST, SETTLE_TICKS, SETTLE_PUTS);
+    asynchronous_fifo_enable_stats(fifo, &stats);
+    memset(&record, 0, sizeof(record));
+    record.min_fill = FIFO_LENGTH;
+
+    while (fifo_sim_ticks(&sim) < SIMULATED_TICKS) {
+        int64_t time;
+        int32_t ts;
+        if (fifo_sim_next(&sim, &time) == FIFO_SIM_PRODUCER) {
+            int len = (int)(fifo->write_ptr - fifo->read_ptr);
+            int reset = fifo->reset, stopped = fifo->stop_producing;
+            uint32_t overflows = record.overflows, resets = record.resets;
+            int64_t timestamp;
+            int n = fifo_sim_asrc_step(&asrc, ratio, time, &timestamp);
+            ts = (int32_t)(time >> 16);
+            ratio = asynchronous_fifo_producer_put(fifo, samples, n, (int32_t)(timestamp >> 16));
+            record_put(&record, fifo, n, len, reset, stopped);
+            asynchronous_fifo_get_stats(fifo, &copy);
+            mismatches += compare(&record, &copy, ratio);
+            if (record.overflows != overflows) {
+                locked_after_overflow = copy.locked_frames;
+            }
+            if (record.resets != resets) {
+                locked_after_reset = copy.locked_frames;
+            }
+            if (ts < STALL_START) {
+                locked_before_overflow = copy.locked_frames;
+            }
+        } else {
+            int32_t out[CHANNELS];
+            ts = (int32_t)(time >> 16);
+            if (ts >= STALL_START && ts < STALL_END) {
+                continue;
+            }
+            if (asynchronous_fifo_consumer_get(fifo, out, ts) == ASYNCH_FIFO_UNDERFLOW) {
+                record.underflows++;
+            }
+        }
+    }
+    asynchronous_fifo_get_stats(fifo, &copy);
+    printf("stats: fill %d to %d mean %d/256, max phase error %d, locked %u frames (%u before the stall), "
+           "%u overflows %u underflows %u resets, %d mismatches\n",
+           (int)copy.min_fill, (int)copy.max_fill, (int)copy.mean_fill, (int)copy.max_phase_error,
+           (unsigned)copy.locked_frames, (unsigned)locked_before_overflow, (unsigned)copy.overflows,
+           (unsigned)copy.underflows, (unsigned)copy.resets, mismatches);
+    if (mismatches != 0) {
+        errors++;
+    }
+    // Locked before the stall, unlocked by the overflow and the reset, and locked again by the end
+    if (copy.overflows != 1 || copy.underflows != 1 || copy.resets != 1 || locked_before_overflow == 0 ||
+        locked_after_overflow != 0 || locked_after_reset != 0 || copy.locked_frames == 0 ||
+        copy.min_fill >= copy.max_fill) {
+        errors++;
+    }
+    asynchronous_fifo_exit(fifo);
+    return errors;
+}
+
+static int cleared(const asynchronous_fifo_stats_t *copy) {
+    static const asynchronous_fifo_stats_t zero;
+    return memcmp(copy, &zero, sizeof(zero)) == 0;
+}
+
+static int test_stats_off(void) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array;
+    asynchronous_fifo_stats_t stats, copy;
+    int32_t samples[BLOCK_SIZE * CHANNELS] = {0};
+    int errors = 0;
+
+    // Never enabled
+    asynchronous_fifo_init(fifo, CHANNELS, FIFO_LENGTH);
+    asynchronous_fifo_init_PID_fs_codes(fifo, FS_CODE_48, FS_CODE_48);
+    asynchronous_fifo_producer_put(fifo, samples, BLOCK_SIZE, 2083 * BLOCK_SIZE);
+    memset(&copy, 0xa5, sizeof(copy));
+    asynchronous_fifo_get_stats(fifo, &copy);
+    errors += !cleared(&copy);
+
+    // Enabled, used, and disabled again
+    asynchronous_fifo_enable_stats(fifo, &stats);
+    asynchronous_fifo_producer_put(fifo, samples, BLOCK_SIZE, 2083 * BLOCK_SIZE * 2);
+    asynchronous_fifo_enable_stats(fifo, NULL);
+    memset(&copy, 0xa5, sizeof(copy));
+    asynchronous_fifo_get_stats(fifo, &copy);
+    errors += !cleared(&copy);
+    printf("stats off: %d errors\n", errors);
+    asynchronous_fifo_exit(fifo);
+    return errors;
+}
+
+int test_stats(void) {
+    int errors = 0;
+
+    errors += test_known_run();
+    errors += test_stats_off();
+    return errors;
+}
@@ -0,0 +1,165 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that the asynchronous FIFO and the timestamp interpolation are not
+// affected by the wrap of the 32-bit reference clock. Each run is repeated
+// with all timestamps offset so that they cross the signed or the unsigned
+// wrap part way through, and must return exactly the same ratios and fill
+// levels as the run without an offset. Nanosecond timestamps do not scale
+// to a whole number of ticks, so those runs are compared with a tolerance.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asynchronous_fifo.h"
+#include "asrc_timestamp_interpolation.h"
+#include "src.h"
+#include "fifo_sim.h"
+#include "fifo_tests.h"
+
+#define SIMULATED_TICKS     (50000000)      // Half a second, the wrap is half way
+
+#define MODE_PUT            (0)
+#define MODE_PUT_FRACT      (1)
+#define MODE_BULK_GET       (2)
+#define MODE_SCALED         (3)
+
+#define SCALED_TOLERANCE    (4295)          // Of the ratio, 1 ppm
+
+static int64_t array[ASYNCHRONOUS_FIFO_INT64_ELEMENTS(FIFO_LENGTH, CHANNELS)];
+
+typedef struct {
+    uint32_t checksum;                      // Of all ratios and fill levels
+    int32_t  ratio;
+    uint32_t resets;
+} run_result_t;
+
+/*
+ * Runs a 48 kHz to 48 kHz FIFO for SIMULATED_TICKS, with the put and get
+ * events interleaved in time order. All timestamps are offset by offset
+ * ticks, or in MODE_SCALED by offset nanoseconds of a 64-bit clock.
+ */
+static void run_fifo(int mode, uint64_t offset, run_result_t *result) {
+    asynchronous_fifo_t *fifo = (asynchronous_fifo_t *)array;
+    asynchronous_fifo_stats_t stats;
+    int32_t samples[BLOCK_SIZE * CHANNELS] = {0};
+    fifo_sim_t sim;
+    int sample = 0;
+
+    fifo_sim_init(&sim, FIFO_SIM_PERIOD(48000, PRODUCER_PPM), BLOCK_SIZE, 1, FIFO_SIM_PERIOD(48000, 0));
+    if (mode == MODE_BULK_GET) {
+        sim.consumer_block[0] = BLOCK_SIZE;
+    }
+    asynchronous_fifo_init(fifo, CHANNELS, FIFO_LENGTH);
+    asynchronous_fifo_init_PID_fs_codes(fifo, FS_CODE_48, FS_CODE_48);
+    asynchronous_fifo_enable_stats(fifo, &stats);
+    if (mode == MODE_SCALED) {
+        asynchronous_fifo_init_timestamp_scale(fifo, ASYNCHRONOUS_FIFO_TIMESTAMP_SCALE(1000000000));
+    }
+    result->checksum = 0;
+
+    while (fifo_sim_ticks(&sim) < SIMULATED_TICKS) {
+        int64_t time;
+        if (fifo_sim_next(&sim, &time) == FIFO_SIM_PRODUCER) {
+            for(int i = 0; i < BLOCK_SIZE * CHANNELS; i++) {
+                samples[i] = sample++;
+            }
+            int32_t ratio;
+            if (mode == MODE_SCALED) {
+                // Nanoseconds, ten per tick, so the offset is a whole number of ticks
+                uint64_t ns = (uint64_t)((time * 10) >> 16) + offset;
+                uint32_t fract;
+                int32_t ts = asynchronous_fifo_scale_timestamp(fifo, ns, &fract);
+                ratio = asynchronous_fifo_producer_put_fract(fifo, samples, BLOCK_SIZE, ts, fract);
+            } else {
+                uint32_t ts = (uint32_t)(time >> 16) + (uint32_t)offset;
+                uint32_t fract = (uint32_t)time << 16;
+                if (mode == MODE_PUT_FRACT) {
+                    ratio = asynchronous_fifo_producer_put_fract(fifo, samples, BLOCK_SIZE, ts, fract);
+                } else {
+                    ratio = asynchronous_fifo_producer_put(fifo, samples, BLOCK_SIZE, ts);
+                }
+            }
+            result->checksum = result->checksum * 31 + ratio;
+            result->checksum = result->checksum * 31 + (fifo->write_ptr - fifo->read_ptr);
+        } else {
+            int32_t out[BLOCK_SIZE * CHANNELS];
+            int32_t ts;
+            if (mode == MODE_SCALED) {
+                ts = asynchronous_fifo_scale_timestamp(fifo, (uint64_t)((time * 10) >> 16) + offset, NULL);
+            } else {
+                ts = (uint32_t)(time >> 16) + (uint32_t)offset;
+            }
+            if (sim.consumer_block[0] > 1) {
+                asynchronous_fifo_consumer_get_bulk(fifo, out, sim.consumer_block[0], ts, 0);
+            } else {
+                asynchronous_fifo_consumer_get(fifo, out, ts);
+            }
+        }
+    }
+    asynchronous_fifo_get_stats(fifo, &stats);
+    result->ratio = fifo->ratio;
+    result->resets = stats.resets + stats.underflows + stats.overflows;
+    asynchronous_fifo_exit(fifo);
+}
+
+static int test_fifo(int mode, uint64_t offset) {
+    run_result_t reference, wrapped;
+    run_fifo(mode, 0, &reference);
+    run_fifo(mode, offset, &wrapped);
+    printf("mode %d offset 0x%08x%08x: ratio %d %d resets %d %d checksum %08x %08x\n", mode,
+           (unsigned)(offset >> 32), (unsigned)offset, (int)reference.ratio, (int)wrapped.ratio,
+           (int)reference.resets, (int)wrapped.resets,
+           (unsigned)reference.checksum, (unsigned)wrapped.checksum);
+    if (reference.resets != wrapped.resets) {
+        return 1;
+    }
+    if (mode == MODE_SCALED) {
+        return abs(reference.ratio - wrapped.ratio) > SCALED_TOLERANCE;
+    }
+    return reference.checksum != wrapped.checksum || reference.ratio != wrapped.ratio;
+}
+
+static int test_interpolation(void) {
+    static const uint32_t timestamps[] = {0x7fffff00, 0x7fffffff, 0xffffff00, 0xffffffff};
+    asrc_ctrl_t asrc_ctrl;
+    int errors = 0;
+
+    memset(&asrc_ctrl, 0, sizeof(asrc_ctrl));
+    for(int t = 0; t < sizeof(timestamps) / sizeof(timestamps[0]); t++) {
+        for(int i = 127; i <= 129; i++) {
+            asrc_ctrl.iTimeInt = i;
+            asrc_ctrl.uiTimeFract = 0x9abcdef0;
+            uint32_t fract, fract_0;
+            int32_t ts   = asrc_timestamp_interpolation(timestamps[t], &asrc_ctrl, 2083);
+            int32_t ts_0 = asrc_timestamp_interpolation(0, &asrc_ctrl, 2083);
+            int32_t tsf   = asrc_timestamp_interpolation_fract(timestamps[t], &asrc_ctrl, 2083, &fract);
+            int32_t tsf_0 = asrc_timestamp_interpolation_fract(0, &asrc_ctrl, 2083, &fract_0);
+            if ((uint32_t)ts - (uint32_t)ts_0 != timestamps[t] ||
+                (uint32_t)tsf - (uint32_t)tsf_0 != timestamps[t] || fract != fract_0) {
+                printf("Interpolation error at 0x%08x\n", (unsigned)timestamps[t]);
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+int test_wrap(void) {
+    // Offsets that put the signed and unsigned wrap of the tick count half way through
+    uint32_t signed_wrap = 0x80000000u - SIMULATED_TICKS / 2;
+    uint32_t unsigned_wrap = 0u - SIMULATED_TICKS / 2;
+    int errors = 0;
+
+    for(int mode = MODE_PUT; mode <= MODE_BULK_GET; mode++) {
+        errors += test_fifo(mode, signed_wrap);
+        errors += test_fifo(mode, unsigned_wrap);
+    }
+    // 64-bit nanoseconds, crossing 2^32 ns and the wrap of the scaled ticks
+    errors += test_fifo(MODE_SCALED, (1ull << 32) - SIMULATED_TICKS * 5ull);
+    errors += test_fifo(MODE_SCALED, ((uint64_t)unsigned_wrap + 0x300000000ull) * 10);
+    errors += test_fifo(MODE_SCALED, 1700000000ull * 1000000000ull);
+    errors += test_interpolation();
+    return errors;
+}
@@ -1,7 +1,8 @@
 # Copyright 2023-2024 XMOS LIMITED.
 # This Software is subject to the terms of the XMOS Public Licence: Version 1.
 import pytest
-from utils.src_test_utils import generate_mips_report
+import os
+from utils.src_test_utils import generate_mips_report, generate_bench_report
 
 def pytest_sessionfinish(session, exitstatus):
     """
@@ -14,3 +15,7 @@ def pytest_sessionfinish(session, exitstatus):
 
     for mips_report_type in ["ssrc", "asrc"]:
         generate_mips_report(mips_report_type)
+
+    generate_bench_report("xsim", cpu_hz=600e6)
+    host_cpu_hz = os.environ.get("SRC_BENCH_HOST_CPU_HZ")
+    generate_bench_report("host", cpu_hz=float(host_cpu_hz) if host_cpu_hz else None)
@@ -0,0 +1,493 @@
+// Copyright 2024 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+// ===========================================================================
+// ===========================================================================
+//
+// Benchmark of the lib_src processing functions
+//
+// Times each public processing function over every rate pair, channel count
+// and block size it supports and prints one CSV row per configuration to
+// stdout, with the total time and the time of the longest call. Builds for xcore (run under xsim or on hardware) and natively for
+// the host, where only SSRC and ASRC are available.
+//
+// Usage: src_bench [-k kernel] [-f in_fs_code] [-g out_fs_code]
+//                  [-c max_channels] [-n in_samples] [-e fs_deviation]
+//
+// ===========================================================================
+// ===========================================================================
+
+// ===========================================================================
+//
+// Includes
+//
+// ===========================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+//General SRC configuration defines, sized for the largest benchmarked configuration
+#define     BENCH_MAX_CHANNELS               8  //Maximum number of channels per instance
+#define     BENCH_MAX_BLOCK                  16 //Maximum number of input samples per channel per call
+#define     BENCH_N_OUT_IN_RATIO_MAX         5  //Max ratio between samples out:in per processing step (44.1->192 is worst case)
+
+#define     SSRC_N_CHANNELS                  BENCH_MAX_CHANNELS
+#define     SSRC_N_IN_SAMPLES                BENCH_MAX_BLOCK
+#define     ASRC_N_CHANNELS                  BENCH_MAX_CHANNELS
+
+#include "src.h"
+#if defined(__XS3A__)
+#include "src_ff3_fir_coefs.h"
+#include "src_rat_fir_coefs.h"
+#endif
+
+#if defined(__xcore__)
+#include <xcore/hwtimer.h>
+#define     BENCH_TICKS_HZ                   100000000  //Reference timer
+static inline uint32_t bench_time(void) {return get_reference_time();}
+#else
+#include <time.h>
+#define     BENCH_TICKS_HZ                   1000000000 //CLOCK_MONOTONIC in ns
+static inline uint32_t bench_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+// ===========================================================================
+//
+// Variables
+//
+// ===========================================================================
+
+const int sample_rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+const unsigned block_sizes[] = {4, 8, 16};
+#define     BENCH_N_BLOCK_SIZES              (sizeof(block_sizes) / sizeof(block_sizes[0]))
+
+// Command line selection. NULL / -1 selects everything
+static const char*  pzKernel = NULL;
+static int          iInFs = -1;
+static int          iOutFs = -1;
+static unsigned     uiMaxChannels = BENCH_MAX_CHANNELS;
+static unsigned     uiNInSamples = 256;
+static double       fFsRatioDeviation = 1.0;
+
+// Buffers shared by all kernels (only one is benchmarked at a time)
+static int          in_buff[BENCH_MAX_BLOCK * BENCH_MAX_CHANNELS];
+static int          out_buff[BENCH_MAX_BLOCK * BENCH_N_OUT_IN_RATIO_MAX * BENCH_MAX_CHANNELS];
+
+static ssrc_state_t         ssrc_state[BENCH_MAX_CHANNELS];
+static int                  ssrc_stack[BENCH_MAX_CHANNELS][SSRC_STACK_LENGTH_MULT * BENCH_MAX_BLOCK];
+static ssrc_ctrl_t          ssrc_ctrl[BENCH_MAX_CHANNELS];
+
+static asrc_state_t         asrc_state[BENCH_MAX_CHANNELS];
+static int                  asrc_stack[BENCH_MAX_CHANNELS][ASRC_STACK_LENGTH_MULT * BENCH_MAX_BLOCK];
+static asrc_ctrl_t          asrc_ctrl[BENCH_MAX_CHANNELS];
+static asrc_adfir_coefs_t   asrc_adfir_coefs;
+
+// ===========================================================================
+//
+// Local functions
+//
+// ===========================================================================
+
+static int bench_selected(const char* pzName)
+{
+    return (pzKernel == NULL) || (strcmp(pzKernel, pzName) == 0);
+}
+
+static int bench_rates_selected(int iIn, int iOut)
+{
+    return ((iInFs < 0) || (iInFs == iIn)) && ((iOutFs < 0) || (iOutFs == iOut));
+}
+
+// Pseudo random input so results do not depend on the test signals
+static void bench_fill(int* piBuff, unsigned uiN)
+{
+    static uint32_t uiSeed = 12345;
+
+    for(unsigned ui = 0; ui < uiN; ui++)
+    {
+        uiSeed = uiSeed * 1664525 + 1013904223;
+        piBuff[ui] = (int)uiSeed >> 2;
+    }
+}
+
+// uiNIn and uiNOut count samples per channel. For SSRC and ASRC uiNOut is the sum of what the kernel
+// returned, so a kernel that does not run, or runs at the wrong ratio, shows up as an out:in count that
+// does not match the rates; the fixed ratio kernels always produce the same count
+// Adds the time of one call to the total and keeps the longest, which is what a real time caller has to budget for
+static void bench_add(uint64_t* pulTicks, uint32_t* puiPeak, uint32_t uiTicks)
+{
+    *pulTicks += uiTicks;
+    if(uiTicks > *puiPeak)
+        *puiPeak = uiTicks;
+}
+
+static void bench_report(const char* pzName, int iIn, int iOut, unsigned uiNChannels, unsigned uiBlock,
+        unsigned uiNIn, unsigned uiNOut, uint64_t ulTicks, uint32_t uiPeak)
+{
+    printf("%s,%d,%d,%u,%u,%u,%u,%llu,%u,%u\n", pzName, iIn, iOut, uiNChannels, uiBlock, uiNIn, uiNOut,
+            (unsigned long long)ulTicks, (unsigned)uiPeak, (unsigned)BENCH_TICKS_HZ);
+}
+
+static void bench_ssrc(void)
+{
+    if(!bench_selected("ssrc_process")) return;
+
+    for(int iIn = 0; iIn < 6; iIn++) for(int iOut = 0; iOut < 6; iOut++)
+    {
+        if(!bench_rates_selected(iIn, iOut)) continue;
+
+        for(unsigned uiNCh = 1; uiNCh <= uiMaxChannels; uiNCh++) for(unsigned ub = 0; ub < BENCH_N_BLOCK_SIZES; ub++)
+        {
+            unsigned    uiBlock = block_sizes[ub];
+            uint64_t    ulTicks = 0;
+            uint32_t    uiPeak = 0;
+            unsigned    uiN;
+            unsigned    uiNOut = 0;
+
+            for(unsigned ui = 0; ui < uiNCh; ui++)
+            {
+                ssrc_ctrl[ui].psState   = &ssrc_state[ui];
+                ssrc_ctrl[ui].piStack   = ssrc_stack[ui];
+            }
+            ssrc_init(iIn, iOut, ssrc_ctrl, uiNCh, uiBlock, OFF);
+
+            for(uiN = 0; uiN + uiBlock <= uiNInSamples; uiN += uiBlock)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, uiBlock * uiNCh);
+                t0 = bench_time();
+                uiNOut += ssrc_process(in_buff, out_buff, ssrc_ctrl);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("ssrc_process", sample_rates[iIn], sample_rates[iOut], uiNCh, uiBlock, uiN, uiNOut, ulTicks, uiPeak);
+        }
+    }
+}
+
+static void bench_asrc(void)
+{
+    if(!bench_selected("asrc_process")) return;
+
+    for(int iIn = 0; iIn < 6; iIn++) for(int iOut = 0; iOut < 6; iOut++)
+    {
+        if(!bench_rates_selected(iIn, iOut)) continue;
+
+        for(unsigned uiNCh = 1; uiNCh <= uiMaxChannels; uiNCh++) for(unsigned ub = 0; ub < BENCH_N_BLOCK_SIZES; ub++)
+        {
+            unsigned    uiBlock = block_sizes[ub];
+            uint64_t    ulTicks = 0;
+            uint32_t    uiPeak = 0;
+            unsigned    uiN;
+            unsigned    uiNOut = 0;
+            uint64_t    ulFsRatio;
+
+            for(unsigned ui = 0; ui < uiNCh; ui++)
+            {
+                asrc_ctrl[ui].psState   = &asrc_state[ui];
+                asrc_ctrl[ui].piStack   = asrc_stack[ui];
+                asrc_ctrl[ui].piADCoefs = asrc_adfir_coefs.iASRCADFIRCoefs;
+            }
+            ulFsRatio = asrc_init(iIn, iOut, asrc_ctrl, uiNCh, uiBlock, OFF);
+            ulFsRatio = (uint64_t)((double)ulFsRatio * fFsRatioDeviation);
+
+            for(uiN = 0; uiN + uiBlock <= uiNInSamples; uiN += uiBlock)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, uiBlock * uiNCh);
+                t0 = bench_time();
+                uiNOut += asrc_process(in_buff, out_buff, ulFsRatio, asrc_ctrl);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("asrc_process", sample_rates[iIn], sample_rates[iOut], uiNCh, uiBlock, uiN, uiNOut, ulTicks, uiPeak);
+        }
+    }
+}
+
+#if defined(__xcore__)
+static void bench_ff3(void)
+{
+    static int          ds3_delay[BENCH_MAX_CHANNELS][SRC_FF3_DS3_DELAY_LEN];
+    static src_ds3_ctrl_t ds3_ctrl[BENCH_MAX_CHANNELS];
+    static int          os3_delay[BENCH_MAX_CHANNELS][SRC_FF3_OS3_DELAY_LEN];
+    static src_os3_ctrl_t os3_ctrl[BENCH_MAX_CHANNELS];
+
+    for(unsigned uiNCh = 1; uiNCh <= uiMaxChannels; uiNCh++)
+    {
+        uint64_t    ulTicks;
+        uint32_t    uiPeak;
+        unsigned    uiN;
+
+        if(bench_selected("src_ds3_proc"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(unsigned ui = 0; ui < uiNCh; ui++)
+            {
+                ds3_ctrl[ui].delay_base = ds3_delay[ui];
+                src_ds3_init(&ds3_ctrl[ui]);
+                src_ds3_sync(&ds3_ctrl[ui]);
+            }
+            for(uiN = 0; uiN + 3 <= uiNInSamples; uiN += 3)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, 3 * uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                {
+                    ds3_ctrl[ui].in_data    = &in_buff[3 * ui];
+                    ds3_ctrl[ui].out_data   = &out_buff[ui];
+                    src_ds3_proc(&ds3_ctrl[ui]);
+                }
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_ds3_proc", 48000, 16000, uiNCh, 3, uiN, uiN / 3, ulTicks, uiPeak);
+        }
+
+        if(bench_selected("src_os3_proc"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(unsigned ui = 0; ui < uiNCh; ui++)
+            {
+                os3_ctrl[ui].delay_base = os3_delay[ui];
+                src_os3_init(&os3_ctrl[ui]);
+                src_os3_sync(&os3_ctrl[ui]);
+            }
+            for(uiN = 0; uiN < uiNInSamples; uiN++)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                {
+                    // One input sample then three output phases
+                    os3_ctrl[ui].in_data    = in_buff[ui];
+                    src_os3_input(&os3_ctrl[ui]);
+                    for(unsigned up = 0; up < 3; up++)
+                        src_os3_proc(&os3_ctrl[ui]);
+                }
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_os3_proc", 16000, 48000, uiNCh, 1, uiN, uiN * 3, ulTicks, uiPeak);
+        }
+    }
+}
+
+static void bench_ff3_voice(void)
+{
+    static int32_t      ds3v_data[BENCH_MAX_CHANNELS][SRC_FF3V_FIR_NUM_PHASES][SRC_FF3V_FIR_TAPS_PER_PHASE];
+    static int32_t      us3v_data[BENCH_MAX_CHANNELS][SRC_FF3V_FIR_TAPS_PER_PHASE];
+
+    for(unsigned uiNCh = 1; uiNCh <= uiMaxChannels; uiNCh++)
+    {
+        uint64_t    ulTicks;
+        uint32_t    uiPeak;
+        unsigned    uiN;
+
+        if(bench_selected("src_ds3_voice_add_sample"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            memset(ds3v_data, 0, sizeof(ds3v_data));
+            for(uiN = 0; uiN + 3 <= uiNInSamples; uiN += 3)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, 3 * uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                {
+                    int64_t     sum = 0;
+
+                    sum = src_ds3_voice_add_sample(sum, ds3v_data[ui][0], src_ff3v_fir_coefs[0], in_buff[3 * ui]);
+                    sum = src_ds3_voice_add_sample(sum, ds3v_data[ui][1], src_ff3v_fir_coefs[1], in_buff[3 * ui + 1]);
+                    out_buff[ui] = (int)src_ds3_voice_add_final_sample(sum, ds3v_data[ui][2], src_ff3v_fir_coefs[2], in_buff[3 * ui + 2]);
+                }
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_ds3_voice_add_sample", 48000, 16000, uiNCh, 3, uiN, uiN / 3, ulTicks, uiPeak);
+        }
+
+        if(bench_selected("src_us3_voice_input_sample"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            memset(us3v_data, 0, sizeof(us3v_data));
+            for(uiN = 0; uiN < uiNInSamples; uiN++)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                {
+                    out_buff[3 * ui] = src_us3_voice_input_sample(us3v_data[ui], src_ff3v_fir_coefs[2], in_buff[ui]);
+                    out_buff[3 * ui + 1] = src_us3_voice_get_next_sample(us3v_data[ui], src_ff3v_fir_coefs[1]);
+                    out_buff[3 * ui + 2] = src_us3_voice_get_next_sample(us3v_data[ui], src_ff3v_fir_coefs[0]);
+                }
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_us3_voice_input_sample", 16000, 48000, uiNCh, 1, uiN, uiN * 3, ulTicks, uiPeak);
+        }
+    }
+}
+#endif // __xcore__
+
+#if defined(__XS3A__)
+static void bench_vpu_voice(void)
+{
+    static int32_t ALIGNMENT(8) ff3_state_ds[BENCH_MAX_CHANNELS][SRC_FF3_FIR_NUM_PHASES][SRC_FF3_FIR_TAPS_PER_PHASE];
+    static int32_t ALIGNMENT(8) ff3_state_us[BENCH_MAX_CHANNELS][SRC_FF3_FIR_TAPS_PER_PHASE];
+    static int32_t ALIGNMENT(8) rat_state_ds[BENCH_MAX_CHANNELS][SRC_RAT_FIR_TAPS_PER_PHASE_DS];
+    static int32_t ALIGNMENT(8) rat_state_us[BENCH_MAX_CHANNELS][SRC_RAT_FIR_TAPS_PER_PHASE_US];
+
+    memset(ff3_state_ds, 0, sizeof(ff3_state_ds));
+    memset(ff3_state_us, 0, sizeof(ff3_state_us));
+    memset(rat_state_ds, 0, sizeof(rat_state_ds));
+    memset(rat_state_us, 0, sizeof(rat_state_us));
+
+    for(unsigned uiNCh = 1; uiNCh <= uiMaxChannels; uiNCh++)
+    {
+        uint64_t    ulTicks;
+        uint32_t    uiPeak;
+        unsigned    uiN;
+
+        if(bench_selected("src_ff3_96t_ds"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(uiN = 0; uiN + 3 <= uiNInSamples; uiN += 3)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, 3 * uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                    src_ff3_96t_ds((int32_t*)&in_buff[3 * ui], (int32_t*)&out_buff[ui], src_ff3_fir_coefs, ff3_state_ds[ui]);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_ff3_96t_ds", 48000, 16000, uiNCh, 3, uiN, uiN / 3, ulTicks, uiPeak);
+        }
+
+        if(bench_selected("src_ff3_96t_us"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(uiN = 0; uiN < uiNInSamples; uiN++)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                    src_ff3_96t_us((int32_t*)&in_buff[ui], (int32_t*)&out_buff[3 * ui], src_ff3_fir_coefs, ff3_state_us[ui]);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_ff3_96t_us", 16000, 48000, uiNCh, 1, uiN, uiN * 3, ulTicks, uiPeak);
+        }
+
+        if(bench_selected("src_rat_2_3_96t_ds"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(uiN = 0; uiN + 3 <= uiNInSamples; uiN += 3)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, 3 * uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                    src_rat_2_3_96t_ds((int32_t*)&in_buff[3 * ui], (int32_t*)&out_buff[2 * ui], src_rat_fir_ds_coefs, rat_state_ds[ui]);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_rat_2_3_96t_ds", 48000, 32000, uiNCh, 3, uiN, uiN / 3 * 2, ulTicks, uiPeak);
+        }
+
+        if(bench_selected("src_rat_3_2_96t_us"))
+        {
+            ulTicks = 0;
+            uiPeak = 0;
+            for(uiN = 0; uiN + 2 <= uiNInSamples; uiN += 2)
+            {
+                uint32_t    t0, t1;
+
+                bench_fill(in_buff, 2 * uiNCh);
+                t0 = bench_time();
+                for(unsigned ui = 0; ui < uiNCh; ui++)
+                    src_rat_3_2_96t_us((int32_t*)&in_buff[2 * ui], (int32_t*)&out_buff[3 * ui], src_rat_fir_us_coefs, rat_state_us[ui]);
+                t1 = bench_time();
+                bench_add(&ulTicks, &uiPeak, t1 - t0);
+            }
+            bench_report("src_rat_3_2_96t_us", 32000, 48000, uiNCh, 2, uiN, uiN / 2 * 3, ulTicks, uiPeak);
+        }
+    }
+}
+#endif // __XS3A__
+
+// ===========================================================================
+//
+// Main
+//
+// ===========================================================================
+
+int main(int argc, char** argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if((argv[i][0] != '-') || (i + 1 >= argc))
+        {
+            fprintf(stderr, "Usage: %s [-k kernel] [-f in_fs_code] [-g out_fs_code] [-c max_channels] [-n in_samples] [-e fs_deviation]\n", argv[0]);
+            return 1;
+        }
+        switch(argv[i][1])
+        {
+            case 'k': pzKernel          = argv[++i]; break;
+            case 'f': iInFs             = atoi(argv[++i]); break;
+            case 'g': iOutFs            = atoi(argv[++i]); break;
+            case 'c': uiMaxChannels     = atoi(argv[++i]); break;
+            case 'n': uiNInSamples      = atoi(argv[++i]); break;
+            case 'e': fFsRatioDeviation = atof(argv[++i]); break;
+            default:
+                fprintf(stderr, "Unknown option %s\n", argv[i]);
+                return 1;
+        }
+    }
+    if((uiMaxChannels < 1) || (uiMaxChannels > BENCH_MAX_CHANNELS))
+    {
+        fprintf(stderr, "Channels must be 1 to %d\n", BENCH_MAX_CHANNELS);
+        return 1;
+    }
+
+    printf("kernel,in_fs,out_fs,channels,block,in_samples,out_samples,ticks,peak_ticks,ticks_hz\n");
+
+    bench_ssrc();
+    bench_asrc();
+#if defined(__xcore__)
+    bench_ff3();
+    bench_ff3_voice();
+#endif
+#if defined(__XS3A__)
+    bench_vpu_voice();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+# Copyright 2024 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+"""
+Runs the asynchronous FIFO tests in the simulator, one case at a time:
+broadcast - two consumers of one producer, one of which stalls
+format    - packed 24-bit and 16-bit frames, bulk gets and decimated timestamps
+pid       - the closed loop with and without the gain boost schedule, and in
+            adaptive depth mode
+stats     - the run time statistics against a record of the same run
+wrap      - timestamps that cross the wrap of the 32-bit reference clock, and
+            scaled 64-bit timestamps
+"""
+
+import pytest
+import subprocess
+from pathlib import Path
+from utils.src_test_utils import build_firmware_xcommon_cmake
+
+testname = "asynchronous_fifo_test"
+CASES = ("broadcast", "format", "pid", "stats", "wrap")
+
+@pytest.mark.prepare
+def test_asynchronous_fifo_prepare():
+    """ Build firmware """
+    build_firmware_xcommon_cmake(Path(__file__).parent / testname)
+
+
+@pytest.mark.main
+@pytest.mark.parametrize("case", CASES)
+def test_asynchronous_fifo(case):
+    """ The app checks the case and exits non zero on a failure """
+    xe = Path(__file__).parent / testname / "bin" / f"{testname}.xe"
+    cmd = f"xsim --args {xe} {case}"
+
+    print(f"Running: {cmd}")
+    output = subprocess.run(cmd.split(), stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(output.stdout)
+    assert output.returncode == 0
+    assert "PASS" in output.stdout
@@ -0,0 +1,88 @@
+# Copyright 2024 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+"""
+Benchmark of every SRC processing function, under xsim and on the host
+
+Not part of the main tests. Build then run with:
+    pytest -m bench -k prepare
+    pytest -n auto -m bench -k "not prepare"
+
+Each run writes its rows to utils/tmp/bench/<target>/ and the session finish
+hook collates them into src_bench_<target>.csv and src_bench_<target>.json,
+which can be diffed between releases. peak_ticks is the longest single call,
+which a real time caller has to budget for. est_cycles_per_sample is derived from
+the time and a nominal clock, 600 MHz under xsim and SRC_BENCH_HOST_CPU_HZ on
+the host; it is left empty when that is not set, leaving only ns per sample.
+"""
+
+import pytest
+import subprocess
+from pathlib import Path
+from utils.src_test_utils import build_firmware_xcommon_cmake, build_host_app_xcommon_cmake
+
+
+bench_dir = Path(__file__).parent / "src_bench"
+results_dir = Path(__file__).parents[1] / "utils" / "tmp" / "bench"
+
+# Sample rate codes, see fs_code_t
+fs_codes = [0, 1, 2, 3, 4, 5]
+mrhf_kernels = ["ssrc_process", "asrc_process"]
+xcore_kernels = ["src_ds3_proc", "src_os3_proc",
+                 "src_ds3_voice_add_sample", "src_us3_voice_input_sample",
+                 "src_ff3_96t_ds", "src_ff3_96t_us",
+                 "src_rat_2_3_96t_ds", "src_rat_3_2_96t_us"]
+
+
+def check_sample_counts(row):
+    """ The output count must follow the rates, to within a block's worth of output either way,
+        or the timing is not of the conversion it claims to be """
+    kernel, in_fs, out_fs, channels, block, in_samples, out_samples = row.split(",")[:7]
+    expected = int(in_samples) * int(out_fs) / int(in_fs)
+    tolerance = int(block) * -(-int(out_fs) // int(in_fs)) + 1
+    assert int(in_samples) > 0 and abs(int(out_samples) - expected) <= tolerance, \
+        f"{kernel} {in_fs}->{out_fs} produced {out_samples} samples from {in_samples}, expected about {expected:.0f}"
+
+
+def run_bench(cmd, target, name):
+    """ Run the benchmark app and save its CSV rows (without header) for collation """
+    output = subprocess.run(cmd, shell=True, capture_output=True, text=True)
+    assert output.returncode == 0, f"Error, stdout: {output.stdout}, stderr: {output.stderr}, running: {cmd}"
+
+    rows = [line for line in output.stdout.splitlines()[1:] if line.count(",") == 9]
+    assert len(rows) > 0, f"No benchmark results from: {cmd}"
+    for row in rows:
+        check_sample_counts(row)
+
+    out_dir = results_dir / target
+    out_dir.mkdir(exist_ok=True, parents=True)
+    with open(out_dir / f"{name}.csv", "wt") as f:
+        f.write("\n".join(rows) + "\n")
+
+
+@pytest.mark.bench
+def test_bench_prepare():
+    build_firmware_xcommon_cmake(bench_dir)
+    build_host_app_xcommon_cmake(bench_dir)
+
+
+@pytest.mark.parametrize("in_fs", fs_codes)
+@pytest.mark.parametrize("kernel", mrhf_kernels)
+@pytest.mark.bench
+def test_bench_mrhf_xsim(kernel, in_fs):
+    xe = bench_dir / "bin" / "src_bench.xe"
+    run_bench(f"xsim --args {xe} -k {kernel} -f {in_fs}", "xsim", f"{kernel}_{in_fs}")
+
+
+@pytest.mark.parametrize("kernel", xcore_kernels)
+@pytest.mark.bench
+def test_bench_xcore_xsim(kernel):
+    xe = bench_dir / "bin" / "src_bench.xe"
+    run_bench(f"xsim --args {xe} -k {kernel}", "xsim", kernel)
+
+
+@pytest.mark.parametrize("kernel", mrhf_kernels)
+@pytest.mark.bench
+def test_bench_mrhf_host(kernel):
+    app = bench_dir / "bin" / "src_bench"
+    run_bench(f"{app} -k {kernel} -n 4096", "host", kernel)
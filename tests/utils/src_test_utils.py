@@ -7,6 +7,7 @@ from pathlib import Path
 import subprocess
 import re
 import shutil
+import json
 import soundfile
 
 
@@ -331,6 +332,45 @@ def generate_mips_report(src_type):
                     vals = re.search(r'(\d+)->(\d+),([\d.]+):([\d.]+)', mf.readlines()[0])
                     mips_report.write(f"{vals.group(1)}, {vals.group(2)}, {vals.group(3)}, {vals.group(4)}\n")
 
+def generate_bench_report(target, cpu_hz=None, num_threads=5):
+    """ Collate the src_bench rows for a target ('xsim' or 'host') into src_bench_<target>.csv
+        and src_bench_<target>.json. Ticks are normalised per input sample per channel, peak_ticks is
+        the longest single call as measured.
+        est_cycles_per_sample is not measured: it is the time scaled by cpu_hz, so it assumes the
+        core ran at cpu_hz throughout. On xcore these are thread cycles, i.e. core cycles divided by
+        num_threads as in max_mips_fron_std_out.
+    """
+    bench_dir = Path(__file__).parent / "tmp" / "bench" / target
+    if not bench_dir.exists():
+        return
+
+    fields = ["kernel", "in_fs", "out_fs", "channels", "block", "in_samples", "out_samples", "ticks", "peak_ticks", "ticks_hz"]
+    results = []
+    for part in sorted(bench_dir.glob("*.csv")):
+        with open(part) as pf:
+            for line in pf.read().splitlines():
+                row = dict(zip(fields, line.split(",")))
+                for field in fields[1:]:
+                    row[field] = int(row[field])
+                n_samples = row["in_samples"] * row["channels"]
+                row["ns_per_sample"] = row["ticks"] * 1e9 / row["ticks_hz"] / n_samples
+                if cpu_hz:
+                    threads = num_threads if target == "xsim" else 1
+                    row["est_cycles_per_sample"] = row["ticks"] * cpu_hz / row["ticks_hz"] / threads / n_samples
+                else:
+                    row["est_cycles_per_sample"] = None
+                results.append(row)
+
+    results.sort(key=lambda r: (r["kernel"], r["in_fs"], r["out_fs"], r["channels"], r["block"]))
+
+    columns = fields + ["ns_per_sample", "est_cycles_per_sample"]
+    with open(f"src_bench_{target}.csv", "w") as bench_report:
+        bench_report.write(",".join(columns) + "\n")
+        for row in results:
+            bench_report.write(",".join("" if row[c] is None else (f"{row[c]:.2f}" if isinstance(row[c], float) else str(row[c])) for c in columns) + "\n")
+    with open(f"src_bench_{target}.json", "w") as bench_report:
+        json.dump(results, bench_report, indent=1)
+
 def array_compare_1d(array_a, array_b, rtol=None, atol=None, close=False, max_print=200, save_comparison_file=False, allow_different_lengths=False, abs_diff_check=False, abs_diff_threshold=34):
     """ Do numpy compare except give useful debug if fails
 